@@ -1,10 +1,5 @@
 @echo off
 
-pushd shaders
-glslangValidator.exe -V shader.vert
-glslangValidator.exe -V shader.frag
-popd
-
 if not exist build\\windows mkdir build\\windows
 
 pushd build\\windows
@@ -8,11 +8,6 @@ if [ ! -d "./build/linux" ]; then
     mkdir "build/linux"
 fi
 
-pushd shaders
-glslangValidator -V shader.vert
-glslangValidator -V shader.frag
-popd
-
 cd build/linux
 cmake ../..
 cmake --build . --target app
@@ -0,0 +1,42 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform cameraUniformBufferObject {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+} camera;
+
+// Matches xr::GpuObject, only the fields the vertex stage needs are read.
+struct GpuObject {
+    mat4 modelMatrix;
+    vec4 positionScale;
+    vec4 positionOffset;
+    vec4 textureCoordinateTransform;
+    vec4 boundingSphere;
+    uvec4 drawRange;
+    uvec4 lodFirstIndex;
+    uvec4 lodIndexCount;
+    vec4 lodError;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer objectBuffer {
+    GpuObject objects[];
+};
+
+// unorm16 attributes, dequantized with the object's position scale and offset.
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inTextureCoordinates;
+
+layout(location = 0) out vec3 fragmentColor;
+layout(location = 1) out vec2 fragmentTextureCoordinates;
+
+void main() {
+    // The culling pass stores the object index as firstInstance of every draw.
+    mat4 modelMatrix = objects[gl_InstanceIndex].modelMatrix;
+    vec3 position = inPosition * objects[gl_InstanceIndex].positionScale.xyz + objects[gl_InstanceIndex].positionOffset.xyz;
+    vec4 textureCoordinateTransform = objects[gl_InstanceIndex].textureCoordinateTransform;
+
+    gl_Position = camera.viewProjection * modelMatrix * vec4(position, 1.0);
+    fragmentColor = vec3(1.0);
+    fragmentTextureCoordinates = inTextureCoordinates * textureCoordinateTransform.xy + textureCoordinateTransform.zw;
+}
@@ -1,20 +1,25 @@
 #version 450
 
-layout(binding = 0) uniform uniformBufferObject {
-    mat4 model;
+layout(set = 0, binding = 0) uniform cameraUniformBufferObject {
     mat4 view;
     mat4 projection;
-} ubo;
+    mat4 viewProjection;
+} camera;
 
+layout(push_constant) uniform objectPushConstants {
+    vec4 textureCoordinateTransform;
+} object;
+
+// unorm16 attributes, the instance's model matrix includes the mesh's position dequantization.
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTextureCoordinates;
+layout(location = 1) in vec2 inTextureCoordinates;
+layout(location = 2) in mat4 inModelMatrix;
 
 layout(location = 0) out vec3 fragmentColor;
 layout(location = 1) out vec2 fragmentTextureCoordinates;
 
 void main() {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition, 1.0);
-    fragmentColor = inColor;
-    fragmentTextureCoordinates = inTextureCoordinates;
+    gl_Position = camera.viewProjection * inModelMatrix * vec4(inPosition, 1.0);
+    fragmentColor = vec3(1.0);
+    fragmentTextureCoordinates = inTextureCoordinates * object.textureCoordinateTransform.xy + object.textureCoordinateTransform.zw;
 }
@@ -7,8 +7,34 @@
 #include <xRenderer/vulkanWindow.h>
 #include "resource.h"
 
-xr::Model *homeModel;
-xr::Model *vikingRoomModel;
+// Models are streamed in the background, the pointers stay nullptr until their asset is ready.
+xr::AssetStreamer *assetStreamer = nullptr;
+xr::StreamedAsset *homeAsset = nullptr;
+xr::StreamedAsset *vikingRoomAsset = nullptr;
+xr::Model *homeModel = nullptr;
+xr::Model *vikingRoomModel = nullptr;
+std::vector<xr::Model *> sceneModels;
+
+// Copies of the viking room sharing its mesh and texture, drawn as instances of one draw call.
+// The frame pipelining benchmark draws enough of them to make the scene GPU bound.
+const uint32_t VIKING_ROOM_INSTANCE_GRID_SIZE = ENABLE_FRAME_PIPELINING_BENCHMARK ? 48 : 8;
+std::vector<xr::Model *> vikingRoomInstances;
+
+// 'p' cycles through the frame pacing policies, FRAME_RATE_CAP paces to TARGET_FRAME_RATE.
+const float TARGET_FRAME_RATE = 60.0f;
+xr::FramePacingPolicy framePacingPolicy = xr::FramePacingPolicy::THROUGHPUT;
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+// Toggled with 'c', busy waits every frame in place of game logic to make the scene CPU bound.
+const float BENCHMARK_CPU_LOAD_MILLISECONDS = 8.0f;
+bool isBenchmarkCpuLoadEnabled = false;
+#endif
+
+void cycleFramePacingPolicy()
+{
+    framePacingPolicy = static_cast<xr::FramePacingPolicy>((static_cast<uint32_t>(framePacingPolicy) + 1) % 3);
+    renderer->setFramePacingPolicy(framePacingPolicy, TARGET_FRAME_RATE);
+}
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
 {
@@ -40,6 +66,24 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
                     toggleFullscreen(isFullscreen);
                     break;
 
+                // 0x50 is hex value for key 'P' or 'p'
+                case 0x50:
+                    cycleFramePacingPolicy();
+                    break;
+
+                // 0x47 is hex value for key 'G' or 'g'
+                case 0x47:
+                    renderer->setGpuDrivenRenderingEnabled(!vkState->isGpuDrivenRenderingEnabled);
+                    break;
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+                // 0x43 is hex value for key 'C' or 'c'
+                case 0x43:
+                    isBenchmarkCpuLoadEnabled = !isBenchmarkCpuLoadEnabled;
+                    logf("---------- Benchmark CPU load: %d ----------", isBenchmarkCpuLoadEnabled);
+                    break;
+#endif
+
                 default:
                     break;
             }
@@ -66,6 +110,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpszCmdLi
     vkState->surfaceSize.height = 600;
     vkState->vertexShaderFilePath = "../shaders/vert.spv";
     vkState->fragmentShaderFile = "../shaders/frag.spv";
+    vkState->indirectVertexShaderFilePath = "../shaders/indirectVert.spv";
+    vkState->cullComputeShaderFilePath = "../shaders/cullComp.spv";
+    vkState->pipelineCacheFilePath = "pipelineCache.xrpipeline";
+    vkState->isGpuDrivenRenderingAvailable = true;
+
+    // 'g' switches between the GPU driven and the CPU culled path, the recording benchmark only runs on the CPU path.
+    vkState->isGpuDrivenRenderingEnabled = !ENABLE_COMMAND_RECORDING_BENCHMARK;
 
     hGlobalInstance = hInstance;
 
@@ -164,29 +215,23 @@ void initializeVulkan()
     renderer->initGraphicsPiplineCache();
     renderer->initGraphicsPipline();
     renderer->initCommandPool();
+    renderer->initRecordingWorkers();
+    renderer->initGpuCulling();
     renderer->initDepthStencilImage();
     renderer->initMSAAColorImage();
     renderer->initFrameBuffers();
+    renderer->initStagingBuffer(16 * 1024 * 1024);
+    renderer->initGeometryBuffers(64 * 1024 * 1024, 32 * 1024 * 1024);
 
-    homeModel = new xr::Model("../resources/models/chalet/chalet.obj");
-    renderer->initTextureImage(homeModel, "../resources/textures/chalet/chalet.jpg");
-    renderer->initTextureImageView(homeModel);
-    renderer->initTextureSampler(homeModel);
-    renderer->initVertexBuffer(homeModel);
-    renderer->initIndexBuffer(homeModel);
-    renderer->initUniformBuffers(homeModel);
-
-    vikingRoomModel = new xr::Model("../resources/models/vikingRoom/vikingRoom.obj");
-    renderer->initTextureImage(vikingRoomModel, "../resources/textures/vikingRoom/vikingRoom.png");
-    renderer->initTextureImageView(vikingRoomModel);
-    renderer->initTextureSampler(vikingRoomModel);
-    renderer->initVertexBuffer(vikingRoomModel);
-    renderer->initIndexBuffer(vikingRoomModel);
-    renderer->initUniformBuffers(vikingRoomModel);
+    // The smaller viking room is requested with higher priority so something shows up early.
+    assetStreamer = new xr::AssetStreamer(2);
+    homeAsset = assetStreamer->request("../resources/models/chalet/chalet.obj", "../resources/textures/chalet/chalet.jpg", 0);
+    vikingRoomAsset = assetStreamer->request("../resources/models/vikingRoom/vikingRoom.obj", "../resources/textures/vikingRoom/vikingRoom.png", 1);
 
+    renderer->initUniformBuffers();
     renderer->initDescriptorPool(2);
-    renderer->initDescriptorSets({ homeModel, vikingRoomModel });
-    renderer->initCommandBuffers({ homeModel, vikingRoomModel });
+    renderer->initDescriptorSets(sceneModels);
+    renderer->initCommandBuffers();
     renderer->initSynchronizations();
 }
 
@@ -203,28 +248,42 @@ void cleanUp()
     if (renderer != nullptr)
     {
         renderer->waitForIdle();
+
+        // Retire a streaming batch that is still in flight, its models then own GPU resources like ready ones.
+        renderer->waitForUploadBatch();
+        renderer->processStreamedAssets(assetStreamer, 0);
+
         renderer->destroySynchronizations();
         renderer->destroyCommandBuffers();
-        renderer->destroyDescriptorSets({ homeModel, vikingRoomModel });
+        renderer->destroyDescriptorSets(sceneModels);
         renderer->destroyDescriptorPool();
+        renderer->destroyUniformBuffers();
 
-        renderer->destroyUniformBuffers(homeModel);
-        renderer->destroyIndexBuffer(homeModel);
-        renderer->destroyVertexBuffer(homeModel);
-        renderer->destroyTextureSampler(homeModel);
-        renderer->destroyTextureImageView(homeModel);
-        renderer->destroyTextureImage(homeModel);
+        if (homeAsset->isReady())
+        {
+            renderer->destroyIndexBuffer(homeAsset->model);
+            renderer->destroyVertexBuffer(homeAsset->model);
+            renderer->destroyTextureSampler(homeAsset->model);
+            renderer->destroyTextureImageView(homeAsset->model);
+            renderer->destroyTextureImage(homeAsset->model);
+        }
 
-        renderer->destroyUniformBuffers(vikingRoomModel);
-        renderer->destroyIndexBuffer(vikingRoomModel);
-        renderer->destroyVertexBuffer(vikingRoomModel);
-        renderer->destroyTextureSampler(vikingRoomModel);
-        renderer->destroyTextureImageView(vikingRoomModel);
-        renderer->destroyTextureImage(vikingRoomModel);
+        if (vikingRoomAsset->isReady())
+        {
+            renderer->destroyIndexBuffer(vikingRoomAsset->model);
+            renderer->destroyVertexBuffer(vikingRoomAsset->model);
+            renderer->destroyTextureSampler(vikingRoomAsset->model);
+            renderer->destroyTextureImageView(vikingRoomAsset->model);
+            renderer->destroyTextureImage(vikingRoomAsset->model);
+        }
 
+        renderer->destroyGeometryBuffers();
+        renderer->destroyStagingBuffer();
         renderer->destroyFrameBuffers();
         renderer->destroyMSAAColorImage();
         renderer->destroyDepthStencilImage();
+        renderer->destroyGpuCulling();
+        renderer->destroyRecordingWorkers();
         renderer->destroyCommandPool();
         renderer->destroyGraphicsPipline();
         renderer->destroyGraphicsPiplineCache();
@@ -238,18 +297,27 @@ void cleanUp()
     // The surface need to be destroyed before instance is deleted.
     destroyPlatformSpecificSurface();
 
-    if (homeModel)
+    // Instances only reference the mesh of their source, delete them before the source goes away.
+    for (xr::Model *instance : vikingRoomInstances)
     {
-        delete homeModel;
-        homeModel = nullptr;
+        delete instance;
     }
 
-    if (vikingRoomModel)
+    vikingRoomInstances.clear();
+
+    // Joins the workers and deletes the models.
+    if (assetStreamer)
     {
-        delete vikingRoomModel;
-        vikingRoomModel = nullptr;
+        delete assetStreamer;
+        assetStreamer = nullptr;
+        homeAsset = nullptr;
+        vikingRoomAsset = nullptr;
     }
 
+    homeModel = nullptr;
+    vikingRoomModel = nullptr;
+    sceneModels.clear();
+
     if (renderer)
     {
         // Instance is deleted in destructor of Renderer class.
@@ -268,8 +336,77 @@ void cleanUp()
     logf("---------- Cleanup done ----------");
 }
 
+void updateCamera()
+{
+    // To push object deep into screen, modify the eye matrix to have more positive (greater) value at z-axis.
+    glm::mat4 view = glm::lookAt(glm::vec3(6.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)vkState->surfaceSize.width / (float)vkState->surfaceSize.height, 0.1f, 100.0f);
+
+    // The GLM is designed for OpenGL, where the Y coordinate of the clip coordinate is inverted.
+    // If we do not fix this then the image will be rendered upside-down.
+    // The easy way to fix this is to flip the sign on the scaling factor of Y axis
+    // in the projection matrix.
+    projection[1][1] *= -1.0f;
+
+    renderer->updateCamera(view, projection);
+}
+
+void updateStreamedModels()
+{
+    // Uploads the assets the workers have finished and retires completed uploads, without blocking.
+    renderer->processStreamedAssets(assetStreamer, 4);
+
+    if (homeModel == nullptr && homeAsset->isReady())
+    {
+        homeModel = homeAsset->model;
+        sceneModels.push_back(homeModel);
+    }
+
+    if (vikingRoomModel == nullptr && vikingRoomAsset->isReady())
+    {
+        vikingRoomModel = vikingRoomAsset->model;
+        sceneModels.push_back(vikingRoomModel);
+
+        // A grid of rooms behind the scene, they do not move so their transforms are only set once.
+        for (uint32_t row = 0; row < VIKING_ROOM_INSTANCE_GRID_SIZE; ++row)
+        {
+            for (uint32_t column = 0; column < VIKING_ROOM_INSTANCE_GRID_SIZE; ++column)
+            {
+                float offset = (VIKING_ROOM_INSTANCE_GRID_SIZE - 1) * 0.5f;
+                xr::Model *instance = new xr::Model(vikingRoomModel);
+                instance->modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(-6.0f - row * 2.5f, (column - offset) * 2.5f, -1.0f));
+
+                vikingRoomInstances.push_back(instance);
+                sceneModels.push_back(instance);
+            }
+        }
+    }
+}
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+void simulateCpuLoad()
+{
+    if (!isBenchmarkCpuLoadEnabled)
+    {
+        return;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    while (std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startTime).count()
+           < BENCHMARK_CPU_LOAD_MILLISECONDS)
+    {
+    }
+}
+#endif
+
 void updateHomeModel()
 {
+    if (homeModel == nullptr)
+    {
+        return;
+    }
+
     static auto startTime = std::chrono::high_resolution_clock::now();
     auto currentTime = std::chrono::high_resolution_clock::now();
     float time = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.0f;
@@ -277,21 +414,16 @@ void updateHomeModel()
     glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.5f, -1.0f));
     glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
-    // To push object deep into screen, modify the eye matrix to have more positive (greater) value at z-axis.
-    memset((void *)&(homeModel->ubo), 0, sizeof(xr::UniformBufferObject));
-    homeModel->ubo.model = translationMatrix * rotationMatrix;
-    homeModel->ubo.view = glm::lookAt(glm::vec3(6.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    homeModel->ubo.projection = glm::perspective(glm::radians(45.0f), (float)vkState->surfaceSize.width / (float)vkState->surfaceSize.height, 0.1f, 100.0f);
-
-    // The GLM is designed for OpenGL, where the Y coordinate of the clip coordinate is inverted.
-    // If we do not fix this then the image will be rendered upside-down.
-    // The easy way to fix this is to flip the sign on the scaling factor of Y axis
-    // in the projection matrix.
-    homeModel->ubo.projection[1][1] *= -1.0f;
+    homeModel->modelMatrix = translationMatrix * rotationMatrix;
 }
 
 void updateVikingRoomModel()
 {
+    if (vikingRoomModel == nullptr)
+    {
+        return;
+    }
+
     static auto startTime = std::chrono::high_resolution_clock::now();
     auto currentTime = std::chrono::high_resolution_clock::now();
     float time = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.0f;
@@ -299,18 +431,7 @@ void updateVikingRoomModel()
     glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(-1.5f, 1.5f, -1.0f));
     glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
-    // To push object deep into screen, modify the eye matrix to have more positive (greater) value at z-axis.
-    memset((void *)&(vikingRoomModel->ubo), 0, sizeof(xr::UniformBufferObject));
-    vikingRoomModel->ubo.model = translationMatrix * rotationMatrix;
-    vikingRoomModel->ubo.view = glm::lookAt(glm::vec3(6.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    vikingRoomModel->ubo.projection =
-        glm::perspective(glm::radians(45.0f), (float)vkState->surfaceSize.width / (float)vkState->surfaceSize.height, 0.1f, 100.0f);
-
-    // The GLM is designed for OpenGL, where the Y coordinate of the clip coordinate is inverted.
-    // If we do not fix this then the image will be rendered upside-down.
-    // The easy way to fix this is to flip the sign on the scaling factor of Y axis
-    // in the projection matrix.
-    vikingRoomModel->ubo.projection[1][1] *= -1.0f;
+    vikingRoomModel->modelMatrix = translationMatrix * rotationMatrix;
 }
 
 int mainLoop()
@@ -354,12 +475,31 @@ int mainLoop()
                         fps = frameCounter;
                         frameCounter = 0;
                         fpsTitle = windowTitle + std::string(" | FPS - ") + std::to_string(fps);
+
+                        xr::CullingStatistics cullingStatistics = renderer->getCullingStatistics();
+                        fpsTitle += " | Visible " + std::to_string(cullingStatistics.visibleCount) + "/" + std::to_string(cullingStatistics.testedCount);
+
+                        xr::FramePacingStatistics framePacingStatistics = renderer->getFramePacingStatistics();
+                        fpsTitle += std::string(" | ") + xr::getFramePacingPolicyName(framePacingStatistics.policy)
+                                  + " | Latency " + std::to_string(framePacingStatistics.latency) + " ms";
                         SetWindowText(hWindow, fpsTitle.c_str());
                     }
 
+                    // Everything updated after beginFrame() is latched into the frame rendered next.
+                    renderer->beginFrame();
+
+                    updateStreamedModels();
+
+                    updateCamera();
+
                     updateHomeModel();
                     updateVikingRoomModel();
-                    renderer->render({ homeModel, vikingRoomModel });
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+                    simulateCpuLoad();
+#endif
+
+                    renderer->render(sceneModels);
                 }
             }
         }
@@ -404,7 +544,7 @@ void resize(uint32_t width, uint32_t height)
 
     if (renderer != nullptr)
     {
-        renderer->recreateSwapChain({ homeModel, vikingRoomModel });
+        renderer->recreateSwapChain();
     }
 }
 
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "model.h"
+#include "mpscQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace xr
+{
+    enum class AssetStatus : uint32_t {
+        QUEUED = 0,
+        LOADING,   // OBJ parse and texture decode on a worker thread.
+        LOADED,    // Waiting in the handoff queue for the render thread.
+        UPLOADING, // Recorded into an upload batch that has not completed yet.
+        READY,     // Model can be passed to Renderer::render().
+        CANCELLED,
+        FAILED
+    };
+
+    // One model plus its texture, requested from AssetStreamer. The streamer owns it, the application keeps
+    // the pointer as handle and polls status. model is only valid to use once status is READY.
+    struct StreamedAsset {
+        uint64_t id = 0;
+        int32_t priority = 0;
+        std::string modelFilePath;
+        std::string textureFilePath;
+        ModelLoadOptions modelLoadOptions = {};
+
+        std::atomic<AssetStatus> status = { AssetStatus::QUEUED };
+        std::atomic<bool> isCancelRequested = { false };
+
+        Model *model = nullptr;
+
+        // Decoded RGBA pixels, released by the render thread once they are uploaded.
+        unsigned char *pixels = nullptr;
+        int textureWidth = 0;
+        int textureHeight = 0;
+
+        double loadTimeInMilliseconds = 0.0;
+
+        bool isReady() const
+        {
+            return this->status.load(std::memory_order_acquire) == AssetStatus::READY;
+        }
+    };
+
+    // Loads models and textures on worker threads so the render loop keeps presenting meanwhile.
+    // Requests are served highest priority first (FIFO within a priority). Loaded assets are handed to the
+    // render thread through a lock-free queue, Renderer::processStreamedAssets() uploads them.
+    // Cancellation is honored until the upload of an asset has been recorded.
+    class AssetStreamer
+    {
+      public:
+        XR_API AssetStreamer(uint32_t workerCount);
+        XR_API ~AssetStreamer();
+
+        XR_API StreamedAsset *request(
+            const char *modelFilePath,
+            const char *textureFilePath,
+            int32_t priority,
+            const ModelLoadOptions &modelLoadOptions = ModelLoadOptions()
+        );
+        XR_API void cancel(StreamedAsset *asset);
+
+        // Render thread only.
+        XR_API bool popLoaded(StreamedAsset **asset);
+        XR_API static void releaseCpuData(StreamedAsset *asset);
+
+        XR_API uint32_t getPendingCount();
+
+        // Assets recorded into the current upload batch, owned by the render thread.
+        std::vector<StreamedAsset *> uploadingAssets;
+
+      private:
+        struct QueuedRequest {
+            int32_t priority = 0;
+            uint64_t id = 0;
+            StreamedAsset *asset = nullptr;
+
+            bool operator<(const QueuedRequest &other) const
+            {
+                // std::priority_queue pops the largest element, older requests win between equal priorities.
+                return (this->priority != other.priority) ? (this->priority < other.priority) : (this->id > other.id);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        std::priority_queue<QueuedRequest> requests;
+        std::mutex requestMutex;
+        std::condition_variable requestCondition;
+        bool isStopping = false;
+
+        MpscQueue<StreamedAsset *> loadedAssets;
+
+        // Every asset ever requested, deleted with the streamer.
+        std::vector<StreamedAsset *> assets;
+        std::atomic<uint32_t> pendingCount = { 0 };
+        uint64_t nextId = 1;
+
+        void workerLoop();
+        void load(StreamedAsset *asset);
+    };
+} // namespace xr
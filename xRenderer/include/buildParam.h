@@ -7,6 +7,11 @@
     #define ENABLE_DEBUG_REPORT_VERBOSE_BIT (ENABLE_DEBUG_REPORT_LOGGING & 1)
     #define ENABLE_DEBUG_REPORT_INFORMATION_BIT (ENABLE_DEBUG_REPORT_LOGGING & 1)
     #define ENABLE_FPS 1
+    #define ENABLE_OBJ_PARSER_VALIDATION 1
+    #define ENABLE_MESH_CACHE 1
+    #define ENABLE_VERTEX_WELD_BENCHMARK 0
+    #define ENABLE_COMMAND_RECORDING_BENCHMARK 0
+    #define ENABLE_FRAME_PIPELINING_BENCHMARK 0
 
 #else
 
@@ -15,5 +20,10 @@
     #define ENABLE_DEBUG_REPORT_VERBOSE_BIT 0
     #define ENABLE_DEBUG_REPORT_INFORMATION_BIT 0
     #define ENABLE_FPS 0
+    #define ENABLE_OBJ_PARSER_VALIDATION 0
+    #define ENABLE_MESH_CACHE 1
+    #define ENABLE_VERTEX_WELD_BENCHMARK 0
+    #define ENABLE_COMMAND_RECORDING_BENCHMARK 0
+    #define ENABLE_FRAME_PIPELINING_BENCHMARK 0
 
 #endif
@@ -7,7 +7,9 @@ namespace xr
     struct QueueFamilyIndices {
         uint32_t graphicsFamilyIndex = UINT32_MAX;
         uint32_t presentFamilyIndex = UINT32_MAX;
+        uint32_t transferFamilyIndex = UINT32_MAX;
         bool hasSeparatePresentQueue = false;
+        bool hasSeparateTransferQueue = false;
     };
 
     struct SurfaceSize {
@@ -27,9 +29,123 @@ namespace xr
         VkPhysicalDeviceMemoryProperties memoryProperties = {};
     };
 
-    struct UniformBufferObject {
-        glm::mat4 model;
+    // Camera data shared by every draw, written once per frame into the uniform ring buffer.
+    struct CameraUniformBufferObject {
         glm::mat4 view;
         glm::mat4 projection;
+        glm::mat4 viewProjection;
+
+        // Inward facing unit normal in xyz and distance in w, read by the GPU culling pass.
+        glm::vec4 frustumPlanes[6];
+
+        // World space camera position in xyz.
+        glm::vec4 position;
+
+        // x pixels covered by one world unit at distance one, y Renderer LOD pixel error threshold.
+        glm::vec4 lodParameters;
+    };
+
+    // Per draw data, delivered through push constants. Transforms come from the per instance stream, see InstanceData.
+    struct ObjectPushConstants {
+        // xy scale, zw offset applied to the unorm16 texture coordinates.
+        glm::vec4 textureCoordinateTransform;
+    };
+
+    // One instanced indexed draw of a frame, every visible instance of a mesh at the same LOD. The transforms are
+    // instanceCount consecutive InstanceData from firstInstance on, they are not part of the recording.
+    struct DrawCommand {
+        ObjectPushConstants pushConstants = {};
+        VkDescriptorSet textureDescriptorSet = VK_NULL_HANDLE;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        uint32_t indexCount = 0;
+        uint32_t firstIndex = 0;
+        int32_t vertexOffset = 0;
+        uint32_t instanceCount = 1;
+        uint32_t firstInstance = 0;
+
+        bool operator==(const DrawCommand &other) const
+        {
+            return this->pushConstants.textureCoordinateTransform == other.pushConstants.textureCoordinateTransform
+                && this->textureDescriptorSet == other.textureDescriptorSet
+                && this->indexType == other.indexType
+                && this->indexCount == other.indexCount
+                && this->firstIndex == other.firstIndex
+                && this->vertexOffset == other.vertexOffset
+                && this->instanceCount == other.instanceCount
+                && this->firstInstance == other.firstInstance;
+        }
+    };
+
+    // Per object data of the GPU driven path (std430), read by the culling compute shader and the indirect vertex shader.
+    // Everything but modelMatrix only changes when the objects are regrouped.
+    struct GpuObject {
+        glm::mat4 modelMatrix;
+
+        // Dequantization of the unorm16 positions, object position = position * positionScale.xyz + positionOffset.xyz.
+        glm::vec4 positionScale;
+        glm::vec4 positionOffset;
+        glm::vec4 textureCoordinateTransform;
+
+        // Object space center in xyz, radius in w.
+        glm::vec4 boundingSphere;
+
+        // vertexOffset (as bits), command slot when not compacting, draw group, first command slot of the group.
+        glm::uvec4 drawRange;
+
+        // Up to four LOD levels, an index count of 0 ends the chain. firstIndex is absolute in the index geometry buffer.
+        glm::uvec4 lodFirstIndex;
+        glm::uvec4 lodIndexCount;
+        glm::vec4 lodError;
+    };
+
+    // Objects sharing a texture and index type, drawn by one indirect draw over their command slots.
+    struct IndirectDrawGroup {
+        VkDescriptorSet textureDescriptorSet = VK_NULL_HANDLE;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        uint32_t firstCommand = 0;
+        uint32_t commandCount = 0;
+
+        bool operator==(const IndirectDrawGroup &other) const
+        {
+            return this->textureDescriptorSet == other.textureDescriptorSet
+                && this->indexType == other.indexType
+                && this->firstCommand == other.firstCommand
+                && this->commandCount == other.commandCount;
+        }
+    };
+
+    // The culling pass always counts the visible objects in drawCounts[0]. When compacting, the visible draws of group g
+    // are appended behind its first command and counted in drawCounts[1 + g], otherwise every object keeps its own
+    // command slot and hidden ones get an instanceCount of 0.
+    struct GpuCullingPushConstants {
+        uint32_t objectCount = 0;
+        uint32_t isCompacting = 0;
+    };
+
+    // What the command buffers of one frame in flight were recorded with. The frame has one primary command buffer
+    // per swapchain image because the framebuffer is part of the recording, they all share the draws below.
+    struct FrameRecording {
+        std::vector<DrawCommand> drawCommands;
+        std::vector<IndirectDrawGroup> indirectDrawGroups;
+        VkBuffer gpuObjectBuffer = VK_NULL_HANDLE;
+        VkBuffer instanceBuffer = VK_NULL_HANDLE;
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        std::vector<bool> isImageRecorded;
+
+        // Secondary command buffers holding the draws, executed in order by every image's primary buffer.
+        uint32_t secondaryCommandBufferCount = 0;
+    };
+
+    // Frame time sums of ENABLE_FRAME_PIPELINING_BENCHMARK. render() alternates runs of serialized frames, which end
+    // with a device wait, and pipelined ones, fenceWaitTime is the time the CPU blocked on frame and image fences.
+    struct FramePipeliningBenchmark {
+        bool isSerialized = true;
+        uint32_t frameCount = 0;
+        std::chrono::high_resolution_clock::time_point lastFrameTime = {};
+        float frameTime = 0.0f;
+        float fenceWaitTime = 0.0f;
+        float frameFenceWaitTime = 0.0f;
+        float serializedFrameTime = 0.0f;
     };
 } // namespace xr
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "platform.h"
+
+namespace xr
+{
+    enum class FramePacingPolicy : uint32_t {
+        LOW_LATENCY = 0, // One frame in flight, the application latches input once the previous frame finished.
+        THROUGHPUT,      // Every frame in flight is used, the CPU runs ahead of the GPU to keep it busy.
+        FRAME_RATE_CAP   // Two frames in flight, frame starts are spaced to the target frame rate by sleeping.
+    };
+
+    XR_API const char *getFramePacingPolicyName(FramePacingPolicy policy);
+
+    // Averages over the last FramePacer statistics window. latency is CPU submit to GPU completion of a frame,
+    // the present follows it, without a display timing extension this is the closest the renderer can observe.
+    struct FramePacingStatistics {
+        FramePacingPolicy policy = FramePacingPolicy::THROUGHPUT;
+        uint32_t framesInFlight = 0;
+        float frameTime = 0.0f;
+        float latency = 0.0f;
+        float maxLatency = 0.0f;
+    };
+
+    // Decides how many frames may be in flight and when the next frame may start, and measures frame latency.
+    // The renderer reports submits and completed fences, the pacer does not touch Vulkan itself.
+    class FramePacer
+    {
+      public:
+        void setPolicy(FramePacingPolicy policy, float targetFrameRate);
+        FramePacingPolicy getPolicy() const;
+        uint32_t getFramesInFlight(uint32_t maxFramesInFlight) const;
+
+        // Sleeps until the next frame may start under FRAME_RATE_CAP, returns at once for the other policies.
+        void waitForFrameStart();
+
+        void onSubmit(size_t frameIndex);
+        bool isFramePending(size_t frameIndex) const;
+        void onFrameComplete(size_t frameIndex);
+
+        FramePacingStatistics getStatistics(uint32_t maxFramesInFlight) const;
+
+      private:
+        FramePacingPolicy policy = FramePacingPolicy::THROUGHPUT;
+        std::chrono::high_resolution_clock::duration framePeriod = {};
+        std::chrono::high_resolution_clock::time_point nextFrameStartTime = {};
+        std::chrono::high_resolution_clock::time_point lastFrameStartTime = {};
+
+        // Submit time of the frame in flight in each slot, pending until its fence is seen signaled.
+        std::vector<std::chrono::high_resolution_clock::time_point> submitTimes;
+        std::vector<bool> isPending;
+
+        uint32_t windowFrameCount = 0;
+        uint32_t windowLatencyCount = 0;
+        float windowFrameTime = 0.0f;
+        float windowLatency = 0.0f;
+        float windowMaxLatency = 0.0f;
+        FramePacingStatistics statistics = {};
+    };
+} // namespace xr
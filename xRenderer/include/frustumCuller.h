@@ -0,0 +1,44 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "model.h"
+
+namespace xr
+{
+    // Gribb, Hartmann plane extraction for a [0, 1] depth range, see GLM_FORCE_DEPTH_ZERO_TO_ONE. Planes are normalized,
+    // xyz is the inward facing normal and w the distance, a point is inside when dot(normal, point) + w >= 0.
+    void extractFrustumPlanes(const glm::mat4 &viewProjection, glm::vec4 planes[6]);
+
+    struct CullingStatistics {
+        uint32_t testedCount = 0;
+        uint32_t visibleCount = 0;
+        uint32_t culledCount = 0;
+        float cullTime = 0.0f;
+    };
+
+    // Tests world space bounding spheres against the six planes of a view projection matrix.
+    // Spheres are kept as separate x, y, z, radius arrays so the plane loop runs over contiguous floats
+    // and is vectorized by the compiler, four or eight objects per instruction.
+    class FrustumCuller
+    {
+      public:
+        void setFrustum(const glm::mat4 &viewProjection);
+
+        // Appends the models whose bounding sphere intersects the frustum to visibleModels, in their original order.
+        void cull(const std::vector<Model *> &models, std::vector<Model *> *visibleModels);
+
+        CullingStatistics getStatistics() const;
+
+      private:
+        std::array<glm::vec4, 6> planes = {};
+
+        std::vector<float> centersX;
+        std::vector<float> centersY;
+        std::vector<float> centersZ;
+        std::vector<float> radii;
+        std::vector<uint32_t> visibilityMasks;
+
+        CullingStatistics statistics = {};
+    };
+} // namespace xr
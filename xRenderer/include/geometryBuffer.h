@@ -0,0 +1,31 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "memoryAllocator.h"
+#include "rangeAllocator.h"
+
+namespace xr
+{
+    // Sub-range of a GeometryBuffer owned by one model.
+    using GeometryAllocation = RangeAllocation;
+
+    // One device local buffer shared by the geometry of every model, vertex data and index data each get their own.
+    // Models only own ranges inside it, so a frame binds the buffer once and draws with vertexOffset / firstIndex.
+    // The Vulkan objects are created and resized by Renderer, the inherited allocator only tracks the ranges.
+    class GeometryBuffer : public RangeAllocator
+    {
+      public:
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation bufferAllocation = {};
+        VkBufferUsageFlags usage = 0;
+    };
+
+    // Buffer replaced by a grow that frames in flight or a pending copy may still read. It is destroyed once a frame
+    // submitted after it was retired has completed, frame numbers count the frames submitted, see VulkanState.
+    struct RetiredBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation bufferAllocation = {};
+        uint64_t lastFrameNumber = 0;
+    };
+} // namespace xr
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "memoryAllocator.h"
+
+namespace xr
+{
+    // Buffers the GPU culling pass of one frame in flight works on, see Renderer::initGpuCulling().
+    struct GpuCullingFrame {
+        // Persistently mapped GpuObject array, written by the host before the frame is submitted.
+        VkBuffer objectBuffer = VK_NULL_HANDLE;
+        MemoryAllocation objectBufferAllocation = {};
+
+        // VkDrawIndexedIndirectCommand per object, written by the culling pass and only read by the GPU.
+        VkBuffer drawCommandBuffer = VK_NULL_HANDLE;
+        MemoryAllocation drawCommandBufferAllocation = {};
+
+        // Visible total followed by one count per draw group, host visible so the statistics can be read back.
+        VkBuffer drawCountBuffer = VK_NULL_HANDLE;
+        MemoryAllocation drawCountBufferAllocation = {};
+
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+        // Objects the buffers hold, they only grow once the frame's fence has signaled.
+        uint32_t objectCapacity = 0;
+
+        // Objects are regrouped rarely, the static part of a GpuObject is only rewritten when this falls behind.
+        uint64_t objectOrderVersion = 0;
+
+        // Model matrix last written to each object slot, only slots whose model moved are written again.
+        std::vector<glm::mat4> objectTransforms;
+    };
+} // namespace xr
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "rangeAllocator.h"
+
+#include <mutex>
+
+namespace xr
+{
+    class MemoryBlock;
+
+    // Handle to a sub-range of device memory handed out by MemoryAllocator.
+    // Buffers and images bind to (memory, offset), the rest is bookkeeping used to return the range.
+    struct MemoryAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+
+        // Points at offset inside the persistently mapped block, nullptr for non host visible memory.
+        void *mappedData = nullptr;
+
+        uint32_t memoryTypeIndex = UINT32_MAX;
+        MemoryBlock *block = nullptr;
+        VkDeviceSize rangeOffset = 0;
+        VkDeviceSize rangeSize = 0;
+    };
+
+    class MemoryBlock
+    {
+      public:
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeIndex = UINT32_MAX;
+        uint32_t poolIndex = UINT32_MAX;
+        bool isDedicated = false;
+        void *mappedData = nullptr;
+
+        // Offsets in use inside memory, its capacity is size.
+        RangeAllocator ranges;
+
+        bool allocate(VkDeviceSize requiredSize, VkDeviceSize alignment, MemoryAllocation *allocation);
+        void free(const MemoryAllocation *allocation);
+    };
+
+    struct MemoryAllocatorStatistics {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedAllocationCount = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize reservedBytes = 0;
+        VkDeviceSize usedBytes = 0;
+    };
+
+    // Sub-allocates buffers and images from large VkDeviceMemory blocks, one pool of blocks per memory type.
+    // Linear resources (buffers, linear images) and optimal images use separate pools so that
+    // bufferImageGranularity never has to be considered within a block.
+    class MemoryAllocator
+    {
+      public:
+        MemoryAllocator(VkDevice device, const GpuDetails *gpuDetails);
+        ~MemoryAllocator();
+
+        VkResult allocate(
+            const VkMemoryRequirements *memoryRequirements,
+            VkMemoryPropertyFlags memoryPropertyFlags,
+            bool isLinearResource,
+            bool isDedicated,
+            MemoryAllocation *allocation
+        );
+        void free(MemoryAllocation *allocation);
+
+        // Make host writes visible to the device, no-op for host coherent memory.
+        void flush(const MemoryAllocation *allocation);
+
+        MemoryAllocatorStatistics getStatistics();
+        void printStatistics();
+
+      private:
+        VkDevice device = VK_NULL_HANDLE;
+        VkPhysicalDeviceMemoryProperties memoryProperties = {};
+        VkDeviceSize nonCoherentAtomSize = 1;
+        uint32_t maxMemoryAllocationCount = 0;
+        uint32_t deviceMemoryCount = 0;
+
+        // Pool index is (memoryTypeIndex * 2) + (isLinearResource ? 1 : 0).
+        std::vector<std::vector<MemoryBlock *>> pools;
+        std::vector<MemoryBlock *> dedicatedBlocks;
+        std::mutex mutex;
+
+        VkDeviceSize preferredBlockSize(uint32_t memoryTypeIndex);
+        VkResult createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, uint32_t poolIndex, bool isDedicated, MemoryBlock **block);
+        void destroyBlock(MemoryBlock *block);
+    };
+} // namespace xr
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "vertex.h"
+#include "meshSimplifier.h"
+
+namespace xr
+{
+    // "XRMC", bump MESH_CACHE_VERSION whenever the header or the CompactVertex layout changes.
+    static const uint32_t MESH_CACHE_MAGIC = 0x434D5258;
+    static const uint32_t MESH_CACHE_VERSION = 5;
+
+    // Bytes hashed from each end of the OBJ for MeshCacheKey::sourceSampleHash.
+    static const uint64_t MESH_CACHE_SOURCE_SAMPLE_SIZE = 64 * 1024;
+
+    // Everything a cached mesh depends on, a cache built with a different key is stale.
+    struct MeshCacheKey {
+        // Size, modification time and FNV-1a hash of the first and last MESH_CACHE_SOURCE_SAMPLE_SIZE bytes of the OBJ,
+        // all read without loading the file. sourceHash covers the whole file and is only checked when the
+        // modification time differs, a copied or checked out file keeps its cache if its content did not change.
+        uint64_t sourceSize = 0;
+        uint64_t sourceModifiedTime = 0;
+        uint64_t sourceSampleHash = 0;
+        uint64_t sourceHash = 0;
+
+        // ModelLoadOptions the mesh was built with.
+        float weldTolerance = 0.0f;
+        uint32_t optimizationFlags = 0;
+        uint32_t maxLodCount = 0;
+        uint32_t reserved = 0;
+    };
+
+    // File layout: header, vertexCount CompactVertex structs at vertexDataOffset, indexCount indices of indexStride
+    // bytes at indexDataOffset, lodCount MeshLod at lodDataOffset. Data offsets are 16 byte aligned so the mapped
+    // arrays are uploaded in place.
+    struct MeshCacheHeader {
+        uint32_t magic = MESH_CACHE_MAGIC;
+        uint32_t version = MESH_CACHE_VERSION;
+        uint32_t vertexStride = sizeof(CompactVertex);
+        uint32_t indexStride = sizeof(uint32_t);
+
+        MeshCacheKey key = {};
+
+        uint64_t vertexCount = 0;
+        uint64_t indexCount = 0;
+        uint64_t lodCount = 0;
+        uint64_t vertexDataOffset = 0;
+        uint64_t indexDataOffset = 0;
+        uint64_t lodDataOffset = 0;
+
+        float boundsMin[4] = {};
+        float boundsMax[4] = {};
+
+        // xyz center, w radius.
+        float boundingSphere[4] = {};
+        float textureCoordinateTransform[4] = {};
+    };
+
+    // Packed mesh as written to and read from the cache. On a read, vertices and indices point into the mapped file.
+    struct MeshCacheContents {
+        const CompactVertex *vertices = nullptr;
+        const void *indices = nullptr;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        std::vector<MeshLod> lods;
+
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        glm::vec3 boundingSphereCenter = glm::vec3(0.0f);
+        float boundingSphereRadius = 0.0f;
+        glm::vec4 textureCoordinateTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    };
+
+    // Read only view of a whole file, backed by mmap / MapViewOfFile.
+    class MappedFile
+    {
+      public:
+        MappedFile() = default;
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile();
+
+        bool open(const char *filePath);
+        void close();
+
+        const unsigned char *data = nullptr;
+        size_t size = 0;
+
+      private:
+#if defined(_WIN32)
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#elif defined(__linux)
+        int file = -1;
+#endif
+    };
+
+    std::string getMeshCachePath(const char *modelFilePath);
+
+    // Fills sourceSize, sourceModifiedTime and sourceSampleHash of key, fails when the file cannot be read.
+    bool readMeshSourceStamp(const char *modelFilePath, MeshCacheKey *key);
+
+    // Fails when the file is missing, truncated, from another format version or CompactVertex layout, or was built
+    // with a different key. The OBJ is only read when its modification time differs, it is then left in sourceData.
+    // mappedFile stays open on success and has to outlive the pointers in contents.
+    bool readMeshCache(
+        const char *cachePath,
+        const char *modelFilePath,
+        const MeshCacheKey &key,
+        MappedFile *mappedFile,
+        MeshCacheContents *contents,
+        std::vector<char> *sourceData
+    );
+
+    // Writes to a temporary file first and renames it, a crash never leaves a half written cache behind.
+    bool writeMeshCache(const char *cachePath, const MeshCacheKey &key, const MeshCacheContents &contents);
+} // namespace xr
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "vertex.h"
+
+namespace xr
+{
+    enum MeshOptimizationFlagBits : uint32_t {
+        // Tipsify triangle order followed by vertex fetch order.
+        MESH_OPTIMIZATION_VERTEX_CACHE_BIT = 0x00000001,
+        // Cluster reordering against overdraw, only applied together with MESH_OPTIMIZATION_VERTEX_CACHE_BIT.
+        MESH_OPTIMIZATION_OVERDRAW_BIT = 0x00000002
+    };
+
+    // FIFO post-transform cache size assumed by the optimizer and by analyzeVertexCache().
+    static const uint32_t VERTEX_CACHE_SIZE = 16;
+
+    struct VertexCacheStatistics {
+        // Average cache miss ratio, transformed vertices per triangle (0.5 is ideal for large grids, 3 is worst).
+        float acmr = 0.0f;
+
+        // Average transform to vertex ratio, transformed vertices per unique vertex (1 is ideal).
+        float atvr = 0.0f;
+    };
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> &vertexIndices, size_t vertexCount, uint32_t cacheSize);
+
+    // Reorders triangles for post-transform cache reuse with Tipsify (Sander, Nehab, Barczak 2007).
+    void optimizeVertexCache(std::vector<uint32_t> *vertexIndices, size_t vertexCount, uint32_t cacheSize);
+
+    // Reorders the clusters produced by optimizeVertexCache() so outward facing clusters are drawn first,
+    // triangles keep their order within a cluster so the cache efficiency is mostly preserved.
+    void optimizeOverdraw(std::vector<uint32_t> *vertexIndices, const std::vector<Vertex> &vertices, uint32_t cacheSize);
+
+    // Renumbers vertices in the order they are first referenced by vertexIndices, unreferenced vertices are dropped.
+    void optimizeVertexFetch(std::vector<Vertex> *vertices, std::vector<uint32_t> *vertexIndices);
+} // namespace xr
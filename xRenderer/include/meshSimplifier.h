@@ -0,0 +1,29 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "vertex.h"
+
+namespace xr
+{
+    // One level of detail, a range of Model::vertexIndices that indexes the model's shared vertices.
+    struct MeshLod {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+
+        // Upper bound of the object space distance between this level and LOD 0.
+        float error = 0.0f;
+        uint32_t reserved = 0;
+    };
+
+    // Quadric error metric edge collapse (Garland, Heckbert 1997) that only collapses a vertex onto a neighbour,
+    // so the result indexes the same vertices. Border and UV seam vertices are never removed and collapses
+    // that would flip a triangle are rejected, so the result can stay above targetIndexCount.
+    // error receives the largest collapse error as an object space distance.
+    std::vector<uint32_t> simplifyMesh(
+        const std::vector<Vertex> &vertices,
+        const std::vector<uint32_t> &vertexIndices,
+        size_t targetIndexCount,
+        float *error
+    );
+} // namespace xr
@@ -4,34 +4,108 @@
 #include "common.h"
 #include "debugger.h"
 #include "vertex.h"
+#include "memoryAllocator.h"
+#include "geometryBuffer.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+
+#include <memory>
 
 namespace xr
 {
+    class MappedFile;
+
+    struct ModelLoadOptions {
+        // > 0 also merges vertices whose attributes are within that distance, see VertexWelder.
+        float weldTolerance = 0.0f;
+
+        // MeshOptimizationFlagBits applied after loading.
+        uint32_t optimizationFlags = MESH_OPTIMIZATION_VERTEX_CACHE_BIT;
+
+        // Upper bound of levels of detail including the full mesh, 1 disables simplification.
+        uint32_t maxLodCount = 4;
+    };
+
     class Model
     {
       public:
-        XR_API Model(const char *modelFilePath);
+        XR_API Model(const char *modelFilePath, const ModelLoadOptions &loadOptions = ModelLoadOptions());
+
+        // Instance of instanceSource, drawn with its geometry, texture and descriptor set. Only modelMatrix and
+        // currentLod are its own, it owns no GPU resources and instanceSource must outlive it.
+        XR_API explicit Model(const Model *instanceSource);
         XR_API ~Model();
 
-        std::vector<VkDescriptorSet> descriptorSets;
-        xr::UniformBufferObject ubo;
+        // The model holding the mesh and texture this one is drawn with, itself unless it is an instance.
+        XR_API const Model *getMeshSource() const;
 
+        // Set 1, holds the texture sampler of this model.
+        VkDescriptorSet textureDescriptorSet = VK_NULL_HANDLE;
+        glm::mat4 modelMatrix = glm::mat4(1.0f);
+
+        // Load time mesh, left empty by a mesh cache hit, which only provides the packed data below.
         std::vector<Vertex> vertices;
         std::vector<uint32_t> vertexIndices;
 
-        VkBuffer vertexBuffer = VK_NULL_HANDLE;
-        VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+        // Finest first, every level is a range of the indices over the same vertices. Always holds at least LOD 0.
+        std::vector<MeshLod> lods;
+
+        // Level selected by the renderer for the last recorded frame.
+        uint32_t currentLod = 0;
 
-        VkBuffer indexBuffer = VK_NULL_HANDLE;
-        VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+        // Object space axis aligned bounds of vertices.
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
 
-        std::vector<VkBuffer> uniformBuffers;
-        std::vector<VkDeviceMemory> uniformBuffersMemory;
+        // Object space sphere around vertices, centred on the bounds, used for culling and LOD selection.
+        glm::vec3 boundingSphereCenter = glm::vec3(0.0f);
+        float boundingSphereRadius = 0.0f;
+
+        // Packed copies of vertices / vertexIndices that are uploaded, see CompactVertex.
+        // compactVertexIndices is used instead of vertexIndices when every index fits in 16 bits.
+        std::vector<CompactVertex> compactVertices;
+        std::vector<uint16_t> compactVertexIndices;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+        // What the renderer uploads, indexType indices. Points into the vectors above, or straight into the mapped
+        // mesh cache after a cache hit. indexCount is 0 when the model failed to load.
+        const CompactVertex *packedVertices = nullptr;
+        const void *packedIndices = nullptr;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+
+        // Maps unorm16 positions back to object space, applied in front of modelMatrix.
+        glm::mat4 positionDequantization = glm::mat4(1.0f);
+
+        // Texture coordinate = unorm16 value * xy + zw.
+        glm::vec4 textureCoordinateTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+        // Ranges inside the shared vertex and index geometry buffers, converted to element offsets for vkCmdDrawIndexed.
+        GeometryAllocation vertexAllocation = {};
+        GeometryAllocation indexAllocation = {};
+        int32_t vertexOffset = 0;
+        uint32_t firstIndex = 0;
+
+        // Null for a model that loaded its own mesh.
+        const Model *instanceSource = nullptr;
 
         uint32_t mipLevels = 1;
         VkImage textureImage = VK_NULL_HANDLE;
-        VkDeviceMemory textureImageMemory = VK_NULL_HANDLE;
+        MemoryAllocation textureImageAllocation = {};
         VkImageView textureImageView = VK_NULL_HANDLE;
         VkSampler textureSampler = VK_NULL_HANDLE;
+
+      private:
+        // Reference loader, used when the chunked OBJ parser does not handle the file. Fails on an unreadable or
+        // invalid file, the model is then left empty.
+        bool loadWithTinyObj(const char *modelFilePath, float weldTolerance);
+        void updateBounds();
+        void updateBoundingSphere();
+        void optimize(const char *modelFilePath, uint32_t optimizationFlags);
+        void generateLods(const char *modelFilePath, uint32_t maxLodCount, uint32_t optimizationFlags);
+        void pack();
+
+        // Backs packedVertices / packedIndices after a mesh cache hit.
+        std::unique_ptr<MappedFile> meshCacheFile;
     };
 } // namespace xr
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "platform.h"
+
+#include <atomic>
+
+namespace xr
+{
+    // Unbounded lock-free multi producer, single consumer queue (Vyukov).
+    // Any thread may push, only one thread may pop. Producers never wait on each other or on the consumer,
+    // a push that is still linking its node only makes the queue look empty to the consumer for a moment.
+    template <typename T>
+    class MpscQueue
+    {
+      public:
+        MpscQueue()
+        {
+            this->stub.next.store(nullptr, std::memory_order_relaxed);
+            this->head.store(&(this->stub), std::memory_order_relaxed);
+            this->tail = &(this->stub);
+        }
+
+        ~MpscQueue()
+        {
+            T value;
+
+            while (pop(value))
+            {
+            }
+
+            if (this->tail != &(this->stub))
+            {
+                delete this->tail;
+            }
+        }
+
+        MpscQueue(const MpscQueue &) = delete;
+        MpscQueue &operator=(const MpscQueue &) = delete;
+
+        void push(const T &value)
+        {
+            Node *node = new Node();
+            node->value = value;
+            node->next.store(nullptr, std::memory_order_relaxed);
+
+            Node *previous = this->head.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        bool pop(T &value)
+        {
+            Node *next = this->tail->next.load(std::memory_order_acquire);
+
+            if (next == nullptr)
+            {
+                return false;
+            }
+
+            // The popped node becomes the new dummy tail, the old one is no longer reachable by producers.
+            value = next->value;
+
+            if (this->tail != &(this->stub))
+            {
+                delete this->tail;
+            }
+
+            this->tail = next;
+
+            return true;
+        }
+
+      private:
+        struct Node {
+            std::atomic<Node *> next;
+            T value = {};
+        };
+
+        std::atomic<Node *> head;
+        Node *tail = nullptr;
+        Node stub;
+    };
+} // namespace xr
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "vertex.h"
+
+namespace xr
+{
+    struct ObjParserStatistics {
+        uint32_t chunkCount = 0;
+        size_t fileSize = 0;
+        size_t positionCount = 0;
+        size_t textureCoordinateCount = 0;
+        size_t triangleCount = 0;
+    };
+
+    // Parses the positions, texture coordinates and faces of an OBJ file in line aligned chunks on several threads
+    // and merges the chunks in file order, so the output does not depend on the thread count.
+    // Produces the same de-duplicated vertices and vertexIndices as the tinyobj path in Model.
+    // Returns false for files it does not handle (missing texture coordinate index, out of range index),
+    // the caller is expected to fall back to tinyobj in that case.
+    // threadCount 0 picks a count from the file size and std::thread::hardware_concurrency().
+    // weldTolerance is passed to VertexWelder, 0 only merges equal vertices.
+    bool parseObjFile(
+        const char *filePath,
+        uint32_t threadCount,
+        float weldTolerance,
+        std::vector<Vertex> *vertices,
+        std::vector<uint32_t> *vertexIndices,
+        ObjParserStatistics *statistics
+    );
+
+    // Same as parseObjFile() for a file already in memory, data[fileSize] must be '\0'.
+    bool parseObjData(
+        const char *data,
+        size_t fileSize,
+        uint32_t threadCount,
+        float weldTolerance,
+        std::vector<Vertex> *vertices,
+        std::vector<uint32_t> *vertexIndices,
+        ObjParserStatistics *statistics
+    );
+} // namespace xr
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "platform.h"
+
+namespace xr
+{
+    // Bump whenever PipelineCacheFileHeader changes.
+    static const uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
+    // Prefix of a pipeline cache file, the vkGetPipelineCacheData blob follows. The blob is only valid for the device
+    // and driver it came from and some drivers do not reject foreign data reliably, so it is checked before Vulkan sees it.
+    struct PipelineCacheFileHeader {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t vendorID = 0;
+        uint32_t deviceID = 0;
+        uint32_t driverVersion = 0;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE] = {};
+        uint64_t dataSize = 0;
+        uint64_t dataHash = 0;
+    };
+
+    // Fails when the file is missing, truncated, corrupted or was written for another device, driver or cache UUID.
+    bool readPipelineCache(const char *cachePath, const VkPhysicalDeviceProperties &properties, std::vector<char> *data);
+
+    bool writePipelineCache(const char *cachePath, const VkPhysicalDeviceProperties &properties, const std::vector<char> &data);
+} // namespace xr
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "platform.h"
+
+namespace xr
+{
+    inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    struct MemoryRange {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+
+    // Range handed out by RangeAllocator. offset / size is what the caller asked for, rangeOffset / rangeSize
+    // also cover the alignment padding in front of it and are what free() returns.
+    struct RangeAllocation {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        VkDeviceSize rangeOffset = 0;
+        VkDeviceSize rangeSize = 0;
+    };
+
+    // First fit sub-allocator of the offsets [0, capacity), it never touches the memory or buffer behind them.
+    // Shared by device memory blocks and geometry buffers.
+    class RangeAllocator
+    {
+      public:
+        VkDeviceSize capacity = 0;
+        VkDeviceSize usedSize = 0;
+        uint32_t allocationCount = 0;
+
+        // Free ranges sorted by offset, adjacent ranges are always merged.
+        std::vector<MemoryRange> freeRanges;
+
+        void reset(VkDeviceSize capacity);
+
+        // Existing ranges keep their offsets, the new tail is appended to (or merged with) the last free range.
+        void grow(VkDeviceSize newCapacity);
+
+        // The alignment does not have to be a power of two, geometry ranges are aligned to their element stride.
+        bool allocate(VkDeviceSize requiredSize, VkDeviceSize alignment, RangeAllocation *allocation);
+        void free(RangeAllocation *allocation);
+    };
+} // namespace xr
@@ -4,6 +4,7 @@
 #include "common.h"
 #include "vertex.h"
 #include "vulkanState.h"
+#include "assetStreamer.h"
 
 namespace xr
 {
@@ -46,6 +47,14 @@ namespace xr
         XR_API void initCommandPool();
         XR_API void destroyCommandPool();
 
+        // Threads recording the frame's secondary command buffers, must exist before initCommandBuffers().
+        XR_API void initRecordingWorkers();
+        XR_API void destroyRecordingWorkers();
+
+        // Compute pipeline and per frame buffers of the GPU driven path, a no-op unless isGpuDrivenRenderingAvailable.
+        XR_API void initGpuCulling();
+        XR_API void destroyGpuCulling();
+
         XR_API void initDepthStencilImage();
         XR_API void destroyDepthStencilImage();
 
@@ -53,6 +62,7 @@ namespace xr
         XR_API void destroyMSAAColorImage();
 
         XR_API void initTextureImage(Model *model, const char *textureFilePath);
+        XR_API void initTextureImage(Model *model, const unsigned char *pixels, uint32_t textureWidth, uint32_t textureHeight);
         XR_API void destroyTextureImage(Model *model);
 
         XR_API void initTextureImageView(Model *model);
@@ -61,40 +71,70 @@ namespace xr
         XR_API void initTextureSampler(Model *model);
         XR_API void destroyTextureSampler(Model *model);
 
+        XR_API void initStagingBuffer(VkDeviceSize size);
+        XR_API void destroyStagingBuffer();
+
+        XR_API void beginUploadBatch();
+        XR_API void submitUploadBatch();
+        XR_API bool isUploadBatchComplete();
+        XR_API void waitForUploadBatch();
+
+        XR_API void initGeometryBuffers(VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity);
+        XR_API void destroyGeometryBuffers();
+
         XR_API void initVertexBuffer(Model *model);
         XR_API void destroyVertexBuffer(Model *model);
 
         XR_API void initIndexBuffer(Model *model);
         XR_API void destroyIndexBuffer(Model *model);
 
-        XR_API void initUniformBuffers(Model *model);
-        XR_API void destroyUniformBuffers(Model *model);
+        XR_API void initUniformBuffers();
+        XR_API void destroyUniformBuffers();
 
         XR_API void initDescriptorPool(size_t models);
         XR_API void destroyDescriptorPool();
 
         XR_API void initDescriptorSets(std::vector<Model *> models);
+        XR_API void initTextureDescriptorSet(Model *model);
         XR_API void destroyDescriptorSets(std::vector<Model *> models);
 
-        XR_API void initCommandBuffers(std::vector<Model *> models);
+        XR_API void initCommandBuffers();
         XR_API void destroyCommandBuffers();
 
         XR_API void initSynchronizations();
         XR_API void destroySynchronizations();
 
-        XR_API void recreateSwapChain(std::vector<Model *> models);
-        XR_API void cleanupSwapChain(std::vector<Model *> models);
+        XR_API void recreateSwapChain();
+        XR_API void cleanupSwapChain();
 
+        XR_API void processStreamedAssets(AssetStreamer *assetStreamer, uint32_t maxAssetsPerBatch);
+
+        XR_API void updateCamera(const glm::mat4 &view, const glm::mat4 &projection);
+
+        // Switches the frame pacing policy between frames, targetFrameRate is only used by FRAME_RATE_CAP.
+        XR_API void setFramePacingPolicy(FramePacingPolicy policy, float targetFrameRate = 0.0f);
+
+        // Waits until the next frame may start. Camera and model updates made after it are latched into that frame,
+        // render() calls it itself when the application did not.
+        XR_API void beginFrame();
         XR_API void render(std::vector<Model *> models);
 
+        // Switches between the GPU driven and the CPU culled path between frames, only honoured while the path is available.
+        XR_API void setGpuDrivenRenderingEnabled(bool isEnabled);
+
+        // Counts of the last rendered frame.
+        XR_API CullingStatistics getCullingStatistics();
+        XR_API FramePacingStatistics getFramePacingStatistics();
+
         XR_API VkShaderModule createShaderModule(const std::vector<char> &code);
         XR_API void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags bufferUsage,
             VkMemoryPropertyFlags memoryProperties,
             VkBuffer *buffer,
-            VkDeviceMemory *bufferMemory
+            MemoryAllocation *bufferAllocation
         );
+        XR_API void destroyBuffer(VkBuffer *buffer, MemoryAllocation *bufferAllocation);
         XR_API void createImage(
             uint32_t width,
             uint32_t height,
@@ -105,19 +145,55 @@ namespace xr
             VkImageUsageFlags usage,
             VkMemoryPropertyFlags memoryPropertyFlags,
             VkImage &image,
-            VkDeviceMemory &imageMemory
+            MemoryAllocation &imageAllocation,
+            bool isDedicated = false
         );
+        XR_API void destroyImage(VkImage &image, MemoryAllocation &imageAllocation);
         XR_API void createImageView(VkImage image, VkFormat format, VkImageView &imageView, VkImageAspectFlags imageAspectFlags, uint32_t mipLevels);
-        XR_API void copyBuffer(VkBuffer sourceBuffer, VkBuffer targetBuffer, VkDeviceSize size);
-        XR_API void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+        XR_API void copyBuffer(VkBuffer sourceBuffer, VkBuffer targetBuffer, VkDeviceSize size, VkDeviceSize sourceOffset = 0, VkDeviceSize targetOffset = 0);
+        XR_API void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize bufferOffset = 0, int32_t imageOffsetY = 0, int32_t imageOffsetX = 0);
 
       private:
         VulkanState *vkState = nullptr;
 
         void setupLayersAndExtensions();
-        void beginOneTimeCommand(VkCommandBuffer &commandBuffer);
+        void beginOneTimeCommand(VkCommandBuffer &commandBuffer, bool needsGraphicsQueue = false);
         void endOneTimeCommand(VkCommandBuffer &commandBuffer);
-        void updateUniformBuffer(std::vector<Model *> models, uint32_t imageIndex);
+        void updateUniformBuffer(size_t frameIndex);
+        void createGeometryBuffer(GeometryBuffer *geometryBuffer, VkDeviceSize capacity, VkBufferUsageFlags usage);
+        void growGeometryBuffer(GeometryBuffer *geometryBuffer, VkDeviceSize requiredSize);
+        void retireBuffer(VkBuffer *buffer, MemoryAllocation *bufferAllocation);
+        void releaseRetiredBuffers(uint64_t completedFrameNumber);
+        void flushUploadBatch();
+        void transferBufferOwnership(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+        void transferImageOwnership(VkImage image, VkImageLayout imageLayout, uint32_t mipLevels);
+        VkDeviceSize acquireStagingRange(VkDeviceSize size);
+        void uploadToBuffer(VkBuffer targetBuffer, VkDeviceSize targetOffset, const void *data, VkDeviceSize size);
+        void uploadToImage(VkImage image, const void *pixels, uint32_t width, uint32_t height, uint32_t bytesPerPixel);
+        void uploadImageRowSegments(VkImage image, const void *pixels, uint32_t width, uint32_t height, uint32_t bytesPerPixel);
+        void uploadGeometry(GeometryBuffer *geometryBuffer, GeometryAllocation *allocation, const void *data, VkDeviceSize size, VkDeviceSize stride);
+        void buildDrawCommands(const std::vector<Model *> &models, size_t frameIndex, std::vector<DrawCommand> *drawCommands);
+        void growInstanceBuffer(size_t frameIndex, uint32_t instanceCount);
+        void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t frameIndex);
+        uint32_t recordSecondaryCommandBuffers(size_t frameIndex, const std::vector<DrawCommand> &drawCommands, uint32_t workerCount);
+        void recordDrawCommands(VkCommandBuffer commandBuffer, size_t frameIndex, const DrawCommand *drawCommands, size_t drawCount);
+        void growTextureDescriptorPool();
+        void setViewportAndScissor(VkCommandBuffer commandBuffer);
+        void resetFrameCommandPools(size_t frameIndex);
+#if ENABLE_COMMAND_RECORDING_BENCHMARK
+        void benchmarkCommandRecording(size_t frameIndex, const std::vector<DrawCommand> &drawCommands);
+#endif
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+        void benchmarkFramePipelining(float fenceWaitTime);
+#endif
+        uint32_t selectLod(const Model *model, const glm::vec3 &cameraPosition, float projectionScale) const;
+        void growGpuCullingBuffers(size_t frameIndex, uint32_t objectCount);
+        void destroyGpuCullingBuffers();
+        void updateGpuObjectOrder(const std::vector<Model *> &models);
+        void writeGpuObjects(const std::vector<Model *> &models, size_t frameIndex);
+        void readGpuCullingStatistics(size_t frameIndex);
+        void recordGpuCulling(VkCommandBuffer commandBuffer, size_t frameIndex);
+        void recordIndirectDraws(VkCommandBuffer commandBuffer, size_t frameIndex);
 
         void generateMipmaps(VkImage &image, int32_t textureWidth, int32_t textureHeight, uint32_t mipLevels);
 
@@ -16,5 +16,9 @@ namespace xr {
     XR_API void checkError(const VkResult result, const char* file, const uint32_t lineNumber);
     XR_API uint32_t findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties *gpuMemoryProperties, const VkMemoryRequirements *memoryRequirements, const VkMemoryPropertyFlags memoryPropertyFlags);
     XR_API bool readFile(const char* fileName, std::vector<char> *data);
+    // Writes to a temporary file first and renames it, a crash never leaves a half written file behind.
+    XR_API bool writeFileAtomically(const char* fileName, const char* data, size_t size);
+    // FNV-1a, 64 bit. Checksums cache files, not meant to resist deliberate collisions.
+    XR_API uint64_t hashBytes(const void* data, size_t size);
     XR_API size_t currentDateTime(char *dateTimeString, size_t size);
 }
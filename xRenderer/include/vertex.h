@@ -1,6 +1,7 @@
 #pragma once
 
 #include "platform.h"
+#include "vertexLayout.h"
 
 namespace xr {
     struct Vertex {
@@ -8,50 +9,53 @@ namespace xr {
         glm::vec3 color;
         glm::vec2 textureCoordinates;
 
-        static VkVertexInputBindingDescription getBindingDescription()
-        {
-            VkVertexInputBindingDescription bindingDescription = {};
-            bindingDescription.binding = 0;
-            bindingDescription.stride = sizeof(Vertex);
-            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-            return bindingDescription;
-        }
-
-        static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescription()
-        {
-            VkVertexInputAttributeDescription positionAttributeDescription = {};
-            positionAttributeDescription.binding = 0;
-            positionAttributeDescription.location = 0;
-            positionAttributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
-            positionAttributeDescription.offset = offsetof(Vertex, position);
-
-            VkVertexInputAttributeDescription colorAttributeDescription = {};
-            colorAttributeDescription.binding = 0;
-            colorAttributeDescription.location = 1;
-            colorAttributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
-            colorAttributeDescription.offset = offsetof(Vertex, color);
-
-            VkVertexInputAttributeDescription textureCoordinatesAttributeDescription = {};
-            textureCoordinatesAttributeDescription.binding = 0;
-            textureCoordinatesAttributeDescription.location = 2;
-            textureCoordinatesAttributeDescription.format = VK_FORMAT_R32G32_SFLOAT;
-            textureCoordinatesAttributeDescription.offset = offsetof(Vertex, textureCoordinates);
-
-            std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {
-                positionAttributeDescription,
-                colorAttributeDescription,
-                textureCoordinatesAttributeDescription
-            };
-
-            return attributeDescriptions;
-        }
-
         bool operator==(const Vertex &otherVertex) const
         {
             return position == otherVertex.position && color == otherVertex.color && textureCoordinates == otherVertex.textureCoordinates;
         }
     };
+
+    // GLM_FORCE_DEFAULT_ALIGNED_GENTYPES only pads vec3 to 16 bytes when GLM also uses intrinsics (GLM_FORCE_INTRINSICS),
+    // which this build does not enable. Vertex is therefore 32 bytes here, 48 once intrinsics are turned on.
+    static_assert(sizeof(Vertex) == ((GLM_CONFIG_ALIGNED_GENTYPES == GLM_ENABLE) ? 48 : 32), "Unexpected Vertex size.");
+
+    using VertexFloatLayout = VertexLayout<
+        Vertex,
+        VertexAttribute<0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)>,
+        VertexAttribute<1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)>,
+        VertexAttribute<2, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, textureCoordinates)>
+    >;
+
+    // Vertex as stored in the geometry buffer, 12 bytes. Vertex stays the load time format.
+    // position is unorm16 inside the mesh bounds, Model::positionDequantization maps it back to object space.
+    // textureCoordinates are unorm16 inside the mesh's texture coordinate range, see Model::textureCoordinateTransform.
+    // Vertex::color is always white and is not stored, w of position is padding.
+    struct CompactVertex {
+        uint16_t position[4];
+        uint16_t textureCoordinates[2];
+    };
+
+    static_assert(sizeof(CompactVertex) == 12, "CompactVertex must stay 12 bytes, the mesh cache and vertex input rely on it.");
+
+    using CompactVertexLayout = VertexLayout<
+        CompactVertex,
+        VertexAttribute<0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position)>,
+        VertexAttribute<1, VK_FORMAT_R16G16_UNORM, offsetof(CompactVertex, textureCoordinates)>
+    >;
+
+    // Per instance stream of the CPU drawn path, bound at binding 1 with VK_VERTEX_INPUT_RATE_INSTANCE.
+    // modelMatrix includes the mesh's position dequantization, a mat4 attribute takes four locations.
+    struct InstanceData {
+        glm::mat4 modelMatrix;
+    };
+
+    using InstanceLayout = VertexLayout<
+        InstanceData,
+        VertexAttribute<2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(InstanceData, modelMatrix) + 0 * sizeof(glm::vec4)>,
+        VertexAttribute<3, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(InstanceData, modelMatrix) + 1 * sizeof(glm::vec4)>,
+        VertexAttribute<4, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(InstanceData, modelMatrix) + 2 * sizeof(glm::vec4)>,
+        VertexAttribute<5, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(InstanceData, modelMatrix) + 3 * sizeof(glm::vec4)>
+    >;
 }
 
 namespace std {
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "platform.h"
+
+namespace xr
+{
+    // One vertex attribute of a binding, described entirely by template arguments:
+    // VertexAttribute<location, format, offsetof(VertexType, member)>.
+    template<uint32_t Location, VkFormat Format, uint32_t Offset>
+    struct VertexAttribute {
+        static constexpr uint32_t location = Location;
+        static constexpr VkFormat format = Format;
+        static constexpr uint32_t offset = Offset;
+    };
+
+    // Binding and attribute descriptions of a vertex type, generated at compile time from its attribute list.
+    template<typename VertexType, typename... Attributes>
+    struct VertexLayout {
+        static constexpr uint32_t stride = sizeof(VertexType);
+        static constexpr uint32_t attributeCount = sizeof...(Attributes);
+
+        static constexpr VkVertexInputBindingDescription getBindingDescription(uint32_t binding = 0, VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX)
+        {
+            return VkVertexInputBindingDescription{ binding, stride, inputRate };
+        }
+
+        static constexpr std::array<VkVertexInputAttributeDescription, attributeCount> getAttributeDescription(uint32_t binding = 0)
+        {
+            return std::array<VkVertexInputAttributeDescription, attributeCount>{
+                VkVertexInputAttributeDescription{ Attributes::location, binding, Attributes::format, Attributes::offset }...
+            };
+        }
+    };
+} // namespace xr
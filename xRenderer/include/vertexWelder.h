@@ -0,0 +1,58 @@
+#pragma once
+
+#include "platform.h"
+#include "common.h"
+#include "vertex.h"
+
+namespace xr
+{
+    // Bit pattern of every Vertex attribute, or its grid cell when welding with a tolerance.
+    // Cells are 64 bit so coordinates far from the origin relative to the tolerance keep distinct cells.
+    struct VertexKey {
+        uint64_t values[8] = {};
+
+        bool operator==(const VertexKey &otherKey) const
+        {
+            return memcmp(this->values, otherKey.values, sizeof(this->values)) == 0;
+        }
+    };
+
+    // De-duplicates vertices with a flat open addressing table (linear probing, power of two size).
+    // The first occurrence of a vertex keeps its position in vertices, so with tolerance 0 the result is the same as
+    // the unordered_map<Vertex, uint32_t> lookup it replaces (-0.0 and 0.0 weld, like operator== does).
+    // With tolerance > 0 every attribute is snapped to a grid of that size before hashing and comparing,
+    // vertices falling into the same cells are welded to the first one.
+    class VertexWelder
+    {
+      public:
+        // vertices must be empty, expectedCount is an upper bound of the unique vertices, usually the index count.
+        VertexWelder(std::vector<Vertex> *vertices, size_t expectedCount, float tolerance = 0.0f);
+
+        // Returns the index of vertex in vertices, appending it if it was not seen before.
+        uint32_t weld(const Vertex &vertex);
+
+        size_t getProbeCount() { return this->probeCount; }
+
+      private:
+        std::vector<Vertex> *vertices = nullptr;
+
+        // Parallel to vertices.
+        std::vector<VertexKey> keys;
+
+        // Upper 32 bits hold the upper hash bits to reject most mismatches without touching keys,
+        // lower 32 bits the vertex index, EMPTY_SLOT when unused.
+        std::vector<uint64_t> slots;
+        size_t slotMask = 0;
+        size_t probeCount = 0;
+
+        float tolerance = 0.0f;
+        double inverseTolerance = 0.0;
+
+        VertexKey makeKey(const Vertex &vertex);
+        void grow();
+    };
+
+    // Times the unordered_map de-duplication against VertexWelder on the expanded index stream of a mesh
+    // and logs both, used by ENABLE_VERTEX_WELD_BENCHMARK.
+    void benchmarkVertexWelding(const char *name, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &vertexIndices);
+} // namespace xr
@@ -6,37 +6,112 @@
 #include "model.h"
 #include "instance.h"
 #include "debugger.h"
+#include "memoryAllocator.h"
+#include "geometryBuffer.h"
+#include "frustumCuller.h"
+#include "workerPool.h"
+#include "gpuCulling.h"
+#include "framePacer.h"
+#include "pipelineCache.h"
 
 namespace xr
 {
     class VulkanState
     {
       public:
-        const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+        const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
         const char *vertexShaderFilePath = NULL;
         const char *fragmentShaderFile = NULL;
+        const char *indirectVertexShaderFilePath = NULL;
+        const char *cullComputeShaderFilePath = NULL;
+
+        // Pipeline cache persisted across runs, NULL keeps it in memory only.
+        const char *pipelineCacheFilePath = NULL;
 
         Instance *instance = nullptr;
         Debugger *debugger = nullptr;
+        MemoryAllocator *memoryAllocator = nullptr;
         VkDevice device = VK_NULL_HANDLE;
         VkSurfaceKHR surface = VK_NULL_HANDLE;
         VkQueue graphicsQueue = VK_NULL_HANDLE;
         VkQueue presentQueue = VK_NULL_HANDLE;
+        VkQueue transferQueue = VK_NULL_HANDLE;
         VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+
+        // Extent the swapchain was created with, surfaceSize is already the requested one while a resize is pending.
+        // Attachments, framebuffers, the render area and the viewport are all sized from it.
+        VkExtent2D swapchainExtent = {};
         VkRenderPass renderPass = VK_NULL_HANDLE;
         VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorSetLayout textureDescriptorSetLayout = VK_NULL_HANDLE;
         VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+        bool isPipelineCacheWarm = false;
         VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
         VkPipeline pipeline = VK_NULL_HANDLE;
         VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandPool transferCommandPool = VK_NULL_HANDLE;
         VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+
+        // Texture sets come from descriptorPool until it is full, then from chained pools that double in capacity.
+        // The capacity and used count are those of the pool sets are currently allocated from.
+        std::vector<VkDescriptorPool> textureDescriptorPools;
+        size_t textureDescriptorPoolCapacity = 0;
+        size_t textureDescriptorPoolUsedCount = 0;
+
+        // Set 0, shared by every draw. The frame region is selected with a dynamic offset into uniformRingBuffer.
+        VkDescriptorSet uniformDescriptorSet = VK_NULL_HANDLE;
         VkImage depthImage = VK_NULL_HANDLE;
-        VkDeviceMemory depthImageMemory = VK_NULL_HANDLE;
+        MemoryAllocation depthImageAllocation = {};
         VkImageView depthImageView = VK_NULL_HANDLE;
         VkImage msaaColorImage = VK_NULL_HANDLE;
-        VkDeviceMemory msaaColorImageMemory = VK_NULL_HANDLE;
+        MemoryAllocation msaaColorImageAllocation = {};
         VkImageView msaaColorImageView = VK_NULL_HANDLE;
 
+        // One persistently mapped buffer holding MAX_FRAMES_IN_FLIGHT regions of uniformFrameSize bytes,
+        // each region stores the camera block of that frame.
+        VkBuffer uniformRingBuffer = VK_NULL_HANDLE;
+        MemoryAllocation uniformRingBufferAllocation = {};
+        VkDeviceSize uniformFrameSize = 0;
+
+        // Persistently mapped InstanceData of the CPU drawn path, one buffer per frame in flight holding
+        // instanceCapacities of that frame instances. A frame's buffer only grows once its fence has signaled.
+        // Visible models are sorted by mesh and LOD through instanceOrder so that the instances of one draw are consecutive.
+        std::vector<VkBuffer> instanceBuffers;
+        std::vector<MemoryAllocation> instanceBufferAllocations;
+        std::vector<uint32_t> instanceCapacities;
+        std::vector<uint32_t> instanceOrder;
+
+        // Persistently mapped host buffer every upload goes through, used linearly from stagingBufferHead.
+        // Uploads larger than stagingBufferSize are split into chunks, the buffer is reused once its copies have completed.
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        MemoryAllocation stagingBufferAllocation = {};
+        VkDeviceSize stagingBufferSize = 0;
+        VkDeviceSize stagingBufferHead = 0;
+        uint64_t stagedBytes = 0;
+        uint32_t stagingChunkCount = 0;
+
+        // Transfers recorded between beginUploadBatch() and submitUploadBatch() share uploadCommandBuffer,
+        // which is submitted once and signals uploadFence. With a separate transfer queue, uploadCommandBuffer runs
+        // on it and the graphics-only work (ownership acquire, mip generation) goes into uploadGraphicsCommandBuffer,
+        // which waits on uploadSemaphore. Otherwise both are the same command buffer on the graphics queue.
+        VkCommandBuffer uploadCommandBuffer = VK_NULL_HANDLE;
+        VkCommandBuffer uploadGraphicsCommandBuffer = VK_NULL_HANDLE;
+        VkSemaphore uploadSemaphore = VK_NULL_HANDLE;
+        VkFence uploadFence = VK_NULL_HANDLE;
+        bool isUploadBatchOpen = false;
+        bool isUploadBatchPending = false;
+        uint32_t uploadSubmitCount = 0;
+
+        // Geometry of every model lives in these two buffers, see GeometryBuffer.
+        GeometryBuffer vertexGeometryBuffer = {};
+        GeometryBuffer indexGeometryBuffer = {};
+
+        // Geometry buffers replaced by a grow, released by beginFrame() instead of waiting for the device.
+        // submittedFrameCount numbers the submitted frames, frameNumbers holds the last number submitted in each frame slot.
+        std::vector<RetiredBuffer> retiredBuffers;
+        uint64_t submittedFrameCount = 0;
+        std::vector<uint64_t> frameNumbers;
+
         std::vector<const char *> instanceLayers;
         std::vector<const char *> instanceExtensions;
         std::vector<const char *> deviceExtensions;
@@ -45,12 +120,79 @@ namespace xr
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
         std::vector<VkFence> inFlightFences;
+
+        // Fence of the frame that last rendered to each swapchain image, VK_NULL_HANDLE until the image is first used.
+        // Images are not acquired in frame order, so a frame also waits for the previous user of its image.
+        std::vector<VkFence> imagesInFlight;
         std::vector<VkFramebuffer> framebuffers;
+
+        // One transient pool per frame in flight, reset as a whole once the frame's fence signalled and its draws changed.
+        // commandBuffers holds swapchainImageCount buffers per frame, index is frame * swapchainImageCount + image.
+        std::vector<VkCommandPool> frameCommandPools;
         std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<FrameRecording> frameRecordings;
+        std::vector<DrawCommand> drawCommands;
+        uint64_t recordedCommandBufferCount = 0;
+        uint64_t reusedCommandBufferCount = 0;
+
+        // Draws are recorded into secondary command buffers by up to recordingWorkerCount threads, 0 picks the
+        // hardware thread count. Every worker has its own pool per frame in flight, index is frame * workers + worker.
+        uint32_t recordingWorkerCount = 0;
+        WorkerPool *recordingWorkerPool = nullptr;
+        std::vector<VkCommandPool> secondaryCommandPools;
+        std::vector<VkCommandBuffer> secondaryCommandBuffers;
+#if ENABLE_COMMAND_RECORDING_BENCHMARK
+        size_t benchmarkedDrawCount = 0;
+#endif
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+        FramePipeliningBenchmark framePipeliningBenchmark = {};
+#endif
 
         uint32_t swapchainImageCount = 2;
         size_t currentFrame = 0;
 
+        // Per frame resources exist MAX_FRAMES_IN_FLIGHT times, the pacing policy decides how many of them are cycled.
+        // isFrameBegun is set by beginFrame() so render() does not wait for the frame slot a second time.
+        FramePacer framePacer;
+        uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT;
+        bool isFrameBegun = false;
+
+        CameraUniformBufferObject camera = {};
+
+        // A model switches to a coarser LOD once its simplification error covers at most this many pixels.
+        float lodPixelErrorThreshold = 1.0f;
+
+        // Per frame visibility, visibleModels is reused so culling does not allocate once it reached its size.
+        FrustumCuller frustumCuller;
+        std::vector<Model *> visibleModels;
+
+        // GPU driven path: a compute pass culls every model and writes indirect draws, the CPU only updates transforms.
+        // Available is requested before initLogicalDevice(), which turns it off again when the device lacks multiDrawIndirect,
+        // drawIndirectFirstInstance or compute on the graphics queue. Its pipelines and buffers only exist while available.
+        // Enabled picks the path drawn, see Renderer::setGpuDrivenRenderingEnabled().
+        bool isGpuDrivenRenderingAvailable = false;
+        bool isGpuDrivenRenderingEnabled = false;
+        VkDescriptorSetLayout gpuCullingDescriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout indirectPipelineLayout = VK_NULL_HANDLE;
+        VkPipeline indirectPipeline = VK_NULL_HANDLE;
+        VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+        VkPipeline cullPipeline = VK_NULL_HANDLE;
+        VkDescriptorPool gpuCullingDescriptorPool = VK_NULL_HANDLE;
+        std::vector<GpuCullingFrame> gpuCullingFrames;
+
+        // Null without VK_KHR_draw_indirect_count, draws then keep one command slot per object.
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount = nullptr;
+
+        // Object slots are sorted by draw group. gpuSourceModels and gpuSourceTextureSets are the render() input the
+        // order was built from, gpuObjectOrder maps a slot to its index in it and gpuObjectGroups to its draw group.
+        std::vector<Model *> gpuSourceModels;
+        std::vector<VkDescriptorSet> gpuSourceTextureSets;
+        std::vector<uint32_t> gpuObjectOrder;
+        std::vector<uint32_t> gpuObjectGroups;
+        std::vector<IndirectDrawGroup> indirectDrawGroups;
+        uint64_t gpuObjectOrderVersion = 0;
+        CullingStatistics gpuCullingStatistics = {};
+
         VkSurfaceFormatKHR surfaceFormat = {};
         VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
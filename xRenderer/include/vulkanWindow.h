@@ -19,7 +19,6 @@ void cleanUp();
 
 int mainLoop();
 
-void render(xr::UniformBufferObject *ubo);
 void resize(uint32_t width, uint32_t height);
 void toggleFullscreen(bool isFullscreen);
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "platform.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace xr
+{
+    // Fixed set of threads that run one job at a time, fork join style. The calling thread is worker 0,
+    // worker n > 0 always runs on the same pool thread so per worker resources such as command pools
+    // are only ever touched by one thread.
+    class WorkerPool
+    {
+      public:
+        XR_API WorkerPool(uint32_t workerCount);
+        XR_API ~WorkerPool();
+
+        XR_API uint32_t getWorkerCount() const;
+
+        // Calls job(workerIndex) for every workerIndex < workerCount and returns once all calls returned.
+        XR_API void run(uint32_t workerCount, const std::function<void(uint32_t)> &job);
+
+      private:
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable startCondition;
+        std::condition_variable doneCondition;
+
+        const std::function<void(uint32_t)> *job = nullptr;
+        uint32_t jobWorkerCount = 0;
+        uint32_t runningCount = 0;
+        uint64_t generation = 0;
+        bool isStopping = false;
+
+        void threadLoop(uint32_t workerIndex);
+    };
+} // namespace xr
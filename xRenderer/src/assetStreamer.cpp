@@ -0,0 +1,177 @@
+#include "lib/stb/stb_image.h"
+
+#include "assetStreamer.h"
+
+namespace xr
+{
+    XR_API AssetStreamer::AssetStreamer(uint32_t workerCount)
+    {
+        workerCount = std::max<uint32_t>(workerCount, 1);
+
+        for (uint32_t counter = 0; counter < workerCount; ++counter)
+        {
+            this->workers.emplace_back(&AssetStreamer::workerLoop, this);
+        }
+
+        logf("---------- Asset streamer started with %d workers ----------", workerCount);
+    }
+
+    XR_API AssetStreamer::~AssetStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->requestMutex);
+            this->isStopping = true;
+        }
+
+        this->requestCondition.notify_all();
+
+        for (std::thread &worker : this->workers)
+        {
+            worker.join();
+        }
+
+        this->workers.clear();
+
+        // GPU resources of uploaded models are released by the application through the Renderer
+        // before the streamer is deleted, the Model objects themselves are owned here.
+        for (StreamedAsset *asset : this->assets)
+        {
+            releaseCpuData(asset);
+            delete asset->model;
+            delete asset;
+        }
+
+        this->assets.clear();
+    }
+
+    XR_API StreamedAsset *AssetStreamer::request(
+        const char *modelFilePath,
+        const char *textureFilePath,
+        int32_t priority,
+        const ModelLoadOptions &modelLoadOptions
+    )
+    {
+        StreamedAsset *asset = new StreamedAsset();
+        asset->modelFilePath = modelFilePath;
+        asset->textureFilePath = textureFilePath;
+        asset->modelLoadOptions = modelLoadOptions;
+        asset->priority = priority;
+
+        {
+            std::lock_guard<std::mutex> lock(this->requestMutex);
+
+            asset->id = this->nextId++;
+            this->assets.push_back(asset);
+
+            QueuedRequest queuedRequest = {};
+            queuedRequest.priority = priority;
+            queuedRequest.id = asset->id;
+            queuedRequest.asset = asset;
+            this->requests.push(queuedRequest);
+        }
+
+        this->pendingCount.fetch_add(1, std::memory_order_relaxed);
+        this->requestCondition.notify_one();
+
+        return asset;
+    }
+
+    XR_API void AssetStreamer::cancel(StreamedAsset *asset)
+    {
+        asset->isCancelRequested.store(true, std::memory_order_release);
+    }
+
+    XR_API bool AssetStreamer::popLoaded(StreamedAsset **asset)
+    {
+        if (!this->loadedAssets.pop(*asset))
+        {
+            return false;
+        }
+
+        this->pendingCount.fetch_sub(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    XR_API void AssetStreamer::releaseCpuData(StreamedAsset *asset)
+    {
+        if (asset->pixels != nullptr)
+        {
+            stbi_image_free(asset->pixels);
+            asset->pixels = nullptr;
+        }
+    }
+
+    XR_API uint32_t AssetStreamer::getPendingCount()
+    {
+        return this->pendingCount.load(std::memory_order_relaxed);
+    }
+
+    void AssetStreamer::workerLoop()
+    {
+        while (true)
+        {
+            StreamedAsset *asset = nullptr;
+
+            {
+                std::unique_lock<std::mutex> lock(this->requestMutex);
+                this->requestCondition.wait(lock, [this]() { return this->isStopping || !this->requests.empty(); });
+
+                if (this->isStopping)
+                {
+                    return;
+                }
+
+                asset = this->requests.top().asset;
+                this->requests.pop();
+            }
+
+            load(asset);
+
+            // Cancelled and failed assets still go through the handoff queue, so the render thread is the only
+            // one retiring assets and pendingCount stays exact.
+            this->loadedAssets.push(asset);
+        }
+    }
+
+    void AssetStreamer::load(StreamedAsset *asset)
+    {
+        if (asset->isCancelRequested.load(std::memory_order_acquire))
+        {
+            asset->status.store(AssetStatus::CANCELLED, std::memory_order_release);
+            return;
+        }
+
+        asset->status.store(AssetStatus::LOADING, std::memory_order_release);
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        asset->model = new Model(asset->modelFilePath.c_str(), asset->modelLoadOptions);
+
+        // The texture is decoded to RGBA here as well, the render thread only copies it into the staging buffer.
+        int textureChannels = 0;
+        asset->pixels = stbi_load(asset->textureFilePath.c_str(), &(asset->textureWidth), &(asset->textureHeight), &textureChannels, STBI_rgb_alpha);
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        asset->loadTimeInMilliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+        if (asset->isCancelRequested.load(std::memory_order_acquire))
+        {
+            asset->status.store(AssetStatus::CANCELLED, std::memory_order_release);
+        }
+        else if (asset->pixels == nullptr || asset->model->indexCount == 0)
+        {
+            asset->status.store(AssetStatus::FAILED, std::memory_order_release);
+        }
+        else
+        {
+            asset->status.store(AssetStatus::LOADED, std::memory_order_release);
+        }
+
+        if (asset->status.load(std::memory_order_relaxed) != AssetStatus::LOADED)
+        {
+            releaseCpuData(asset);
+            delete asset->model;
+            asset->model = nullptr;
+        }
+    }
+} // namespace xr
@@ -0,0 +1,152 @@
+#include "framePacer.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace xr
+{
+    // Frames averaged into one FramePacingStatistics.
+    static const uint32_t FRAME_PACING_STATISTICS_FRAMES = 60;
+
+    // Sleeps wake up late by up to a scheduler tick, the last part of a capped frame is spun instead.
+    static const std::chrono::microseconds FRAME_RATE_CAP_SPIN_TIME = std::chrono::microseconds(1500);
+
+    XR_API const char *getFramePacingPolicyName(FramePacingPolicy policy)
+    {
+        switch (policy)
+        {
+            case FramePacingPolicy::LOW_LATENCY:
+                return "low latency";
+
+            case FramePacingPolicy::THROUGHPUT:
+                return "throughput";
+
+            case FramePacingPolicy::FRAME_RATE_CAP:
+                return "frame rate cap";
+
+            default:
+                return "unknown";
+        }
+    }
+
+    void FramePacer::setPolicy(FramePacingPolicy policy, float targetFrameRate)
+    {
+        this->policy = policy;
+        this->framePeriod = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::duration<float>((targetFrameRate > 0.0f) ? 1.0f / targetFrameRate : 0.0f)
+        );
+        this->nextFrameStartTime = std::chrono::high_resolution_clock::now();
+
+        // Measurements of the old policy would skew the first window of the new one.
+        this->windowFrameCount = 0;
+        this->windowLatencyCount = 0;
+        this->windowFrameTime = 0.0f;
+        this->windowLatency = 0.0f;
+        this->windowMaxLatency = 0.0f;
+    }
+
+    FramePacingPolicy FramePacer::getPolicy() const
+    {
+        return this->policy;
+    }
+
+    uint32_t FramePacer::getFramesInFlight(uint32_t maxFramesInFlight) const
+    {
+        switch (this->policy)
+        {
+            case FramePacingPolicy::LOW_LATENCY:
+                return 1;
+
+            case FramePacingPolicy::FRAME_RATE_CAP:
+                return std::min<uint32_t>(2, maxFramesInFlight);
+
+            default:
+                return maxFramesInFlight;
+        }
+    }
+
+    void FramePacer::waitForFrameStart()
+    {
+        auto currentTime = std::chrono::high_resolution_clock::now();
+
+        if (this->policy == FramePacingPolicy::FRAME_RATE_CAP && this->framePeriod.count() > 0)
+        {
+            if (currentTime + FRAME_RATE_CAP_SPIN_TIME < this->nextFrameStartTime)
+            {
+                std::this_thread::sleep_until(this->nextFrameStartTime - FRAME_RATE_CAP_SPIN_TIME);
+            }
+
+            while (std::chrono::high_resolution_clock::now() < this->nextFrameStartTime)
+            {
+            }
+
+            // A frame that started late does not shorten the following ones, the schedule restarts from now.
+            currentTime = std::chrono::high_resolution_clock::now();
+            this->nextFrameStartTime = std::max(this->nextFrameStartTime + this->framePeriod, currentTime);
+        }
+
+        if (this->lastFrameStartTime.time_since_epoch().count() > 0)
+        {
+            this->windowFrameTime += std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - this->lastFrameStartTime).count();
+            ++this->windowFrameCount;
+        }
+
+        this->lastFrameStartTime = currentTime;
+
+        if (this->windowFrameCount >= FRAME_PACING_STATISTICS_FRAMES)
+        {
+            this->statistics.frameTime = this->windowFrameTime / this->windowFrameCount;
+            this->statistics.latency = (this->windowLatencyCount > 0) ? this->windowLatency / this->windowLatencyCount : 0.0f;
+            this->statistics.maxLatency = this->windowMaxLatency;
+
+            this->windowFrameCount = 0;
+            this->windowLatencyCount = 0;
+            this->windowFrameTime = 0.0f;
+            this->windowLatency = 0.0f;
+            this->windowMaxLatency = 0.0f;
+        }
+    }
+
+    void FramePacer::onSubmit(size_t frameIndex)
+    {
+        if (frameIndex >= this->submitTimes.size())
+        {
+            this->submitTimes.resize(frameIndex + 1);
+            this->isPending.resize(frameIndex + 1, false);
+        }
+
+        this->submitTimes[frameIndex] = std::chrono::high_resolution_clock::now();
+        this->isPending[frameIndex] = true;
+    }
+
+    bool FramePacer::isFramePending(size_t frameIndex) const
+    {
+        return frameIndex < this->isPending.size() && this->isPending[frameIndex];
+    }
+
+    void FramePacer::onFrameComplete(size_t frameIndex)
+    {
+        if (!isFramePending(frameIndex))
+        {
+            return;
+        }
+
+        float latency = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - this->submitTimes[frameIndex]
+        ).count();
+
+        this->windowLatency += latency;
+        this->windowMaxLatency = std::max(this->windowMaxLatency, latency);
+        ++this->windowLatencyCount;
+        this->isPending[frameIndex] = false;
+    }
+
+    FramePacingStatistics FramePacer::getStatistics(uint32_t maxFramesInFlight) const
+    {
+        FramePacingStatistics statistics = this->statistics;
+        statistics.policy = this->policy;
+        statistics.framesInFlight = getFramesInFlight(maxFramesInFlight);
+
+        return statistics;
+    }
+} // namespace xr
@@ -0,0 +1,101 @@
+#include "frustumCuller.h"
+
+#include <algorithm>
+
+namespace xr
+{
+    void extractFrustumPlanes(const glm::mat4 &viewProjection, glm::vec4 planes[6])
+    {
+        // glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+        glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+        planes[0] = row3 + row0; // left
+        planes[1] = row3 - row0; // right
+        planes[2] = row3 + row1; // bottom, top in Vulkan clip space
+        planes[3] = row3 - row1; // top, bottom in Vulkan clip space
+        planes[4] = row2;        // near, depth range starts at 0
+        planes[5] = row3 - row2; // far
+
+        for (uint32_t index = 0; index < 6; ++index)
+        {
+            float length = glm::length(glm::vec3(planes[index]));
+            planes[index] = (length > 0.0f) ? planes[index] / length : planes[index];
+        }
+    }
+
+    void FrustumCuller::setFrustum(const glm::mat4 &viewProjection)
+    {
+        extractFrustumPlanes(viewProjection, this->planes.data());
+    }
+
+    void FrustumCuller::cull(const std::vector<Model *> &models, std::vector<Model *> *visibleModels)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        size_t count = models.size();
+
+        this->centersX.resize(count);
+        this->centersY.resize(count);
+        this->centersZ.resize(count);
+        this->radii.resize(count);
+        this->visibilityMasks.assign(count, UINT32_MAX);
+
+        // Object space spheres to world space, the radius grows with the largest axis scale of the model matrix.
+        for (size_t index = 0; index < count; ++index)
+        {
+            const Model *model = models[index];
+            const Model *mesh = model->getMeshSource();
+            glm::vec3 center = glm::vec3(model->modelMatrix * glm::vec4(mesh->boundingSphereCenter, 1.0f));
+            float scale = std::max(
+                glm::length(glm::vec3(model->modelMatrix[0])),
+                std::max(glm::length(glm::vec3(model->modelMatrix[1])), glm::length(glm::vec3(model->modelMatrix[2])))
+            );
+
+            this->centersX[index] = center.x;
+            this->centersY[index] = center.y;
+            this->centersZ[index] = center.z;
+            this->radii[index] = mesh->boundingSphereRadius * scale;
+        }
+
+        const float *centersX = this->centersX.data();
+        const float *centersY = this->centersY.data();
+        const float *centersZ = this->centersZ.data();
+        const float *radii = this->radii.data();
+        uint32_t *visibilityMasks = this->visibilityMasks.data();
+
+        // Branch free so the inner loop vectorizes, a sphere is outside once it is behind any plane by more than its radius.
+        for (const glm::vec4 &plane : this->planes)
+        {
+            for (size_t index = 0; index < count; ++index)
+            {
+                float distance = plane.x * centersX[index] + plane.y * centersY[index] + plane.z * centersZ[index] + plane.w;
+                visibilityMasks[index] &= 0u - static_cast<uint32_t>(distance >= -radii[index]);
+            }
+        }
+
+        uint32_t visibleCount = 0;
+
+        for (size_t index = 0; index < count; ++index)
+        {
+            if (visibilityMasks[index] != 0)
+            {
+                visibleModels->push_back(models[index]);
+                ++visibleCount;
+            }
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        this->statistics.testedCount = static_cast<uint32_t>(count);
+        this->statistics.visibleCount = visibleCount;
+        this->statistics.culledCount = static_cast<uint32_t>(count) - visibleCount;
+        this->statistics.cullTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+    }
+
+    CullingStatistics FrustumCuller::getStatistics() const
+    {
+        return this->statistics;
+    }
+} // namespace xr
@@ -0,0 +1,314 @@
+#include "memoryAllocator.h"
+#include "utils.h"
+#include "logger.h"
+
+#include <algorithm>
+
+namespace xr
+{
+    static const VkDeviceSize LARGE_HEAP_BLOCK_SIZE = 64ull * 1024 * 1024;
+    static const VkDeviceSize SMALL_HEAP_MAX_SIZE = 1024ull * 1024 * 1024;
+
+    static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return value / alignment * alignment;
+    }
+
+    bool MemoryBlock::allocate(VkDeviceSize requiredSize, VkDeviceSize alignment, MemoryAllocation *allocation)
+    {
+        RangeAllocation range = {};
+
+        if (!this->ranges.allocate(requiredSize, alignment, &range))
+        {
+            return false;
+        }
+
+        allocation->memory = this->memory;
+        allocation->offset = range.offset;
+        allocation->size = range.size;
+        allocation->memoryTypeIndex = this->memoryTypeIndex;
+        allocation->block = this;
+        allocation->rangeOffset = range.rangeOffset;
+        allocation->rangeSize = range.rangeSize;
+        allocation->mappedData = this->mappedData ? static_cast<char *>(this->mappedData) + range.offset : nullptr;
+
+        return true;
+    }
+
+    void MemoryBlock::free(const MemoryAllocation *allocation)
+    {
+        RangeAllocation range = {};
+        range.offset = allocation->offset;
+        range.size = allocation->size;
+        range.rangeOffset = allocation->rangeOffset;
+        range.rangeSize = allocation->rangeSize;
+
+        this->ranges.free(&range);
+    }
+
+    MemoryAllocator::MemoryAllocator(VkDevice device, const GpuDetails *gpuDetails)
+    {
+        this->device = device;
+        this->memoryProperties = gpuDetails->memoryProperties;
+        this->nonCoherentAtomSize = std::max<VkDeviceSize>(gpuDetails->properties.limits.nonCoherentAtomSize, 1);
+        this->maxMemoryAllocationCount = gpuDetails->properties.limits.maxMemoryAllocationCount;
+        this->pools.resize(this->memoryProperties.memoryTypeCount * 2);
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        printStatistics();
+
+        for (std::vector<MemoryBlock *> &pool : this->pools)
+        {
+            for (MemoryBlock *block : pool)
+            {
+                if (block->ranges.allocationCount > 0)
+                {
+                    logf("Memory block of type %d destroyed with %d live allocations", block->memoryTypeIndex, block->ranges.allocationCount);
+                }
+
+                destroyBlock(block);
+            }
+
+            pool.clear();
+        }
+
+        for (MemoryBlock *block : this->dedicatedBlocks)
+        {
+            logf("Dedicated memory block of type %d destroyed while still in use", block->memoryTypeIndex);
+            destroyBlock(block);
+        }
+
+        this->dedicatedBlocks.clear();
+        this->device = VK_NULL_HANDLE;
+    }
+
+    VkDeviceSize MemoryAllocator::preferredBlockSize(uint32_t memoryTypeIndex)
+    {
+        uint32_t heapIndex = this->memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        VkDeviceSize heapSize = this->memoryProperties.memoryHeaps[heapIndex].size;
+
+        return heapSize <= SMALL_HEAP_MAX_SIZE ? alignUp(heapSize / 8, 32) : LARGE_HEAP_BLOCK_SIZE;
+    }
+
+    VkResult MemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, uint32_t poolIndex, bool isDedicated, MemoryBlock **block)
+    {
+        if (this->maxMemoryAllocationCount > 0 && this->deviceMemoryCount >= this->maxMemoryAllocationCount)
+        {
+            logf("Memory allocation count limit reached [%d]", this->maxMemoryAllocationCount);
+            return VK_ERROR_TOO_MANY_OBJECTS;
+        }
+
+        VkMemoryAllocateInfo memoryAllocationInfo = {};
+        memoryAllocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memoryAllocationInfo.pNext = nullptr;
+        memoryAllocationInfo.allocationSize = size;
+        memoryAllocationInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkResult result = vkAllocateMemory(this->device, &memoryAllocationInfo, nullptr, &memory);
+
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+
+        MemoryBlock *newBlock = new MemoryBlock();
+        newBlock->memory = memory;
+        newBlock->size = size;
+        newBlock->memoryTypeIndex = memoryTypeIndex;
+        newBlock->poolIndex = poolIndex;
+        newBlock->isDedicated = isDedicated;
+
+        newBlock->ranges.reset(size);
+
+        // Host visible blocks stay mapped for their whole lifetime, a VkDeviceMemory can only be mapped once
+        // and every sub-allocation in the block shares that mapping.
+        if (this->memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            result = vkMapMemory(this->device, memory, 0, VK_WHOLE_SIZE, 0, &(newBlock->mappedData));
+            CHECK_ERROR(result);
+        }
+
+        ++this->deviceMemoryCount;
+        *block = newBlock;
+
+        return VK_SUCCESS;
+    }
+
+    void MemoryAllocator::destroyBlock(MemoryBlock *block)
+    {
+        if (block->mappedData)
+        {
+            vkUnmapMemory(this->device, block->memory);
+            block->mappedData = nullptr;
+        }
+
+        vkFreeMemory(this->device, block->memory, nullptr);
+        block->memory = VK_NULL_HANDLE;
+        --this->deviceMemoryCount;
+
+        delete block;
+    }
+
+    VkResult MemoryAllocator::allocate(
+        const VkMemoryRequirements *memoryRequirements,
+        VkMemoryPropertyFlags memoryPropertyFlags,
+        bool isLinearResource,
+        bool isDedicated,
+        MemoryAllocation *allocation
+    )
+    {
+        uint32_t memoryTypeIndex = findMemoryTypeIndex(&(this->memoryProperties), memoryRequirements, memoryPropertyFlags);
+        VkDeviceSize blockSize = preferredBlockSize(memoryTypeIndex);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // Anything larger than half a block would waste most of a block, give it its own VkDeviceMemory.
+        if (isDedicated || memoryRequirements->size > blockSize / 2)
+        {
+            MemoryBlock *block = nullptr;
+            VkResult result = createBlock(memoryTypeIndex, memoryRequirements->size, UINT32_MAX, true, &block);
+
+            if (result != VK_SUCCESS)
+            {
+                return result;
+            }
+
+            block->allocate(memoryRequirements->size, memoryRequirements->alignment, allocation);
+            this->dedicatedBlocks.push_back(block);
+
+            return VK_SUCCESS;
+        }
+
+        uint32_t poolIndex = (memoryTypeIndex * 2) + (isLinearResource ? 1 : 0);
+        std::vector<MemoryBlock *> &pool = this->pools[poolIndex];
+
+        for (MemoryBlock *block : pool)
+        {
+            if (block->size - block->ranges.usedSize < memoryRequirements->size)
+            {
+                continue;
+            }
+
+            if (block->allocate(memoryRequirements->size, memoryRequirements->alignment, allocation))
+            {
+                return VK_SUCCESS;
+            }
+        }
+
+        MemoryBlock *block = nullptr;
+        VkResult result = createBlock(memoryTypeIndex, blockSize, poolIndex, false, &block);
+
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+
+        pool.push_back(block);
+        block->allocate(memoryRequirements->size, memoryRequirements->alignment, allocation);
+
+        return VK_SUCCESS;
+    }
+
+    void MemoryAllocator::free(MemoryAllocation *allocation)
+    {
+        if (allocation->block == nullptr)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        MemoryBlock *block = allocation->block;
+        block->free(allocation);
+
+        if (block->isDedicated)
+        {
+            this->dedicatedBlocks.erase(std::find(this->dedicatedBlocks.begin(), this->dedicatedBlocks.end(), block));
+            destroyBlock(block);
+        }
+        else if (block->ranges.allocationCount == 0)
+        {
+            // Keep one empty block around per pool so that create/destroy cycles (e.g. staging buffers)
+            // do not hit vkAllocateMemory every time.
+            std::vector<MemoryBlock *> &pool = this->pools[block->poolIndex];
+            size_t emptyBlockCount = std::count_if(pool.begin(), pool.end(), [](MemoryBlock *nextBlock) { return nextBlock->ranges.allocationCount == 0; });
+
+            if (emptyBlockCount > 1)
+            {
+                pool.erase(std::find(pool.begin(), pool.end(), block));
+                destroyBlock(block);
+            }
+        }
+
+        *allocation = {};
+    }
+
+    void MemoryAllocator::flush(const MemoryAllocation *allocation)
+    {
+        if (allocation->block == nullptr || (this->memoryProperties.memoryTypes[allocation->memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            return;
+        }
+
+        VkDeviceSize offset = alignDown(allocation->offset, this->nonCoherentAtomSize);
+        VkDeviceSize size = alignUp(allocation->offset + allocation->size - offset, this->nonCoherentAtomSize);
+
+        VkMappedMemoryRange mappedMemoryRange = {};
+        mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        mappedMemoryRange.pNext = nullptr;
+        mappedMemoryRange.memory = allocation->memory;
+        mappedMemoryRange.offset = offset;
+        mappedMemoryRange.size = std::min(size, allocation->block->size - offset);
+
+        VkResult result = vkFlushMappedMemoryRanges(this->device, 1, &mappedMemoryRange);
+        CHECK_ERROR(result);
+    }
+
+    MemoryAllocatorStatistics MemoryAllocator::getStatistics()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        MemoryAllocatorStatistics statistics = {};
+
+        for (std::vector<MemoryBlock *> &pool : this->pools)
+        {
+            for (MemoryBlock *block : pool)
+            {
+                ++statistics.blockCount;
+                statistics.allocationCount += block->ranges.allocationCount;
+                statistics.reservedBytes += block->size;
+                statistics.usedBytes += block->ranges.usedSize;
+            }
+        }
+
+        for (MemoryBlock *block : this->dedicatedBlocks)
+        {
+            ++statistics.dedicatedAllocationCount;
+            statistics.allocationCount += block->ranges.allocationCount;
+            statistics.reservedBytes += block->size;
+            statistics.usedBytes += block->ranges.usedSize;
+        }
+
+        return statistics;
+    }
+
+    void MemoryAllocator::printStatistics()
+    {
+#ifndef NDEBUG
+
+        MemoryAllocatorStatistics statistics = getStatistics();
+
+        logf("---------- Memory Allocator Statistics ----------");
+        logf("Blocks\t\t\t: %d", statistics.blockCount);
+        logf("Dedicated Allocations\t: %d", statistics.dedicatedAllocationCount);
+        logf("Sub Allocations\t\t: %d", statistics.allocationCount);
+        logf("Reserved Bytes\t\t: %llu", static_cast<unsigned long long>(statistics.reservedBytes));
+        logf("Used Bytes\t\t: %llu", static_cast<unsigned long long>(statistics.usedBytes));
+        logf("---------- Memory Allocator Statistics End ----------");
+
+#endif
+    }
+} // namespace xr
@@ -0,0 +1,343 @@
+#include "meshCache.h"
+
+#include <algorithm>
+
+#if defined(__linux)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xr
+{
+    static uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        this->close();
+    }
+
+    bool MappedFile::open(const char *filePath)
+    {
+        this->close();
+
+#if defined(_WIN32)
+
+        this->file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+        if (this->file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize = {};
+
+        if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            this->close();
+            return false;
+        }
+
+        this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+        if (this->mapping == NULL)
+        {
+            this->close();
+            return false;
+        }
+
+        this->data = static_cast<const unsigned char *>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+        this->size = static_cast<size_t>(fileSize.QuadPart);
+
+#elif defined(__linux)
+
+        this->file = ::open(filePath, O_RDONLY);
+
+        if (this->file == -1)
+        {
+            return false;
+        }
+
+        struct stat fileStat = {};
+
+        if (fstat(this->file, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            this->close();
+            return false;
+        }
+
+        void *mappedData = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, this->file, 0);
+        this->data = (mappedData != MAP_FAILED) ? static_cast<const unsigned char *>(mappedData) : nullptr;
+        this->size = static_cast<size_t>(fileStat.st_size);
+
+#endif
+
+        if (this->data == nullptr)
+        {
+            this->close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+#if defined(_WIN32)
+
+        if (this->data != nullptr)
+        {
+            UnmapViewOfFile(this->data);
+        }
+
+        if (this->mapping != NULL)
+        {
+            CloseHandle(this->mapping);
+            this->mapping = NULL;
+        }
+
+        if (this->file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(this->file);
+            this->file = INVALID_HANDLE_VALUE;
+        }
+
+#elif defined(__linux)
+
+        if (this->data != nullptr)
+        {
+            munmap(const_cast<unsigned char *>(this->data), this->size);
+        }
+
+        if (this->file != -1)
+        {
+            ::close(this->file);
+            this->file = -1;
+        }
+
+#endif
+
+        this->data = nullptr;
+        this->size = 0;
+    }
+
+    // Checked without multiplying count, a count read from a corrupted file could overflow the size.
+    static bool isMeshCacheArrayInFile(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize)
+    {
+        return offset >= sizeof(MeshCacheHeader) && offset % 16 == 0 && offset <= fileSize && count <= (fileSize - offset) / stride;
+    }
+
+    template <typename IndexType>
+    static bool areMeshCacheIndicesInRange(const IndexType *indices, uint64_t indexCount, uint64_t vertexCount)
+    {
+        for (uint64_t index = 0; index < indexCount; ++index)
+        {
+            if (indices[index] >= vertexCount)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::string getMeshCachePath(const char *modelFilePath)
+    {
+        return std::string(modelFilePath) + ".xrmesh";
+    }
+
+    bool readMeshSourceStamp(const char *modelFilePath, MeshCacheKey *key)
+    {
+#if defined(_WIN32)
+
+        WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+
+        if (!GetFileAttributesExA(modelFilePath, GetFileExInfoStandard, &attributes))
+        {
+            return false;
+        }
+
+        key->sourceSize = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+        key->sourceModifiedTime = (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+
+#elif defined(__linux)
+
+        struct stat fileStat = {};
+
+        if (stat(modelFilePath, &fileStat) != 0)
+        {
+            return false;
+        }
+
+        key->sourceSize = static_cast<uint64_t>(fileStat.st_size);
+        key->sourceModifiedTime = static_cast<uint64_t>(fileStat.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(fileStat.st_mtim.tv_nsec);
+
+#endif
+
+        std::ifstream file(modelFilePath, std::ios::binary);
+
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        // Edits that keep the size usually touch the start or the end, an OBJ has its header and face list there.
+        uint64_t headSize = std::min(key->sourceSize, MESH_CACHE_SOURCE_SAMPLE_SIZE);
+        uint64_t tailOffset = std::max(headSize, key->sourceSize - std::min(key->sourceSize, MESH_CACHE_SOURCE_SAMPLE_SIZE));
+        std::vector<char> sample(static_cast<size_t>(headSize + key->sourceSize - tailOffset));
+
+        file.read(sample.data(), static_cast<std::streamsize>(headSize));
+        file.seekg(static_cast<std::streamoff>(tailOffset));
+        file.read(sample.data() + headSize, static_cast<std::streamsize>(sample.size() - headSize));
+
+        if (!file.good())
+        {
+            return false;
+        }
+
+        key->sourceSampleHash = hashBytes(sample.data(), sample.size());
+
+        return true;
+    }
+
+    bool readMeshCache(
+        const char *cachePath,
+        const char *modelFilePath,
+        const MeshCacheKey &key,
+        MappedFile *mappedFile,
+        MeshCacheContents *contents,
+        std::vector<char> *sourceData
+    )
+    {
+        if (!mappedFile->open(cachePath) || mappedFile->size < sizeof(MeshCacheHeader))
+        {
+            mappedFile->close();
+            return false;
+        }
+
+        MeshCacheHeader header;
+        memcpy(&header, mappedFile->data, sizeof(MeshCacheHeader));
+
+        if (header.magic != MESH_CACHE_MAGIC
+            || header.version != MESH_CACHE_VERSION
+            || header.vertexStride != sizeof(CompactVertex)
+            || (header.indexStride != sizeof(uint16_t) && header.indexStride != sizeof(uint32_t))
+            || header.key.sourceSize != key.sourceSize
+            || header.key.sourceSampleHash != key.sourceSampleHash
+            || header.key.weldTolerance != key.weldTolerance
+            || header.key.optimizationFlags != key.optimizationFlags
+            || header.key.maxLodCount != key.maxLodCount)
+        {
+            mappedFile->close();
+            return false;
+        }
+
+        // A touched or copied file keeps its cache when its content is unchanged, only then is the whole OBJ hashed.
+        if (header.key.sourceModifiedTime != key.sourceModifiedTime)
+        {
+            if ((sourceData->empty() && !readFile(modelFilePath, sourceData)) || hashBytes(sourceData->data(), sourceData->size()) != header.key.sourceHash)
+            {
+                mappedFile->close();
+                return false;
+            }
+        }
+
+        // Everything below is drawn by the GPU without further checks, a truncated or corrupted file is rebuilt.
+        if (header.vertexCount == 0
+            || header.vertexCount > UINT32_MAX
+            || header.indexCount == 0
+            || header.indexCount > UINT32_MAX
+            || (header.indexStride == sizeof(uint16_t) && header.vertexCount > 65536)
+            || header.lodCount == 0
+            || header.lodCount > std::max<uint32_t>(key.maxLodCount, 1)
+            || !isMeshCacheArrayInFile(header.vertexDataOffset, header.vertexCount, header.vertexStride, mappedFile->size)
+            || !isMeshCacheArrayInFile(header.indexDataOffset, header.indexCount, header.indexStride, mappedFile->size)
+            || !isMeshCacheArrayInFile(header.lodDataOffset, header.lodCount, sizeof(MeshLod), mappedFile->size))
+        {
+            mappedFile->close();
+            return false;
+        }
+
+        const MeshLod *mappedLods = reinterpret_cast<const MeshLod *>(mappedFile->data + header.lodDataOffset);
+
+        for (uint64_t lodIndex = 0; lodIndex < header.lodCount; ++lodIndex)
+        {
+            const MeshLod &lod = mappedLods[lodIndex];
+
+            if (lod.indexCount == 0 || lod.indexCount % 3 != 0 || static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > header.indexCount)
+            {
+                mappedFile->close();
+                return false;
+            }
+        }
+
+        bool isIndexInRange = (header.indexStride == sizeof(uint16_t))
+                            ? areMeshCacheIndicesInRange(reinterpret_cast<const uint16_t *>(mappedFile->data + header.indexDataOffset), header.indexCount, header.vertexCount)
+                            : areMeshCacheIndicesInRange(reinterpret_cast<const uint32_t *>(mappedFile->data + header.indexDataOffset), header.indexCount, header.vertexCount);
+
+        if (!isIndexInRange)
+        {
+            mappedFile->close();
+            return false;
+        }
+
+        contents->vertices = reinterpret_cast<const CompactVertex *>(mappedFile->data + header.vertexDataOffset);
+        contents->indices = mappedFile->data + header.indexDataOffset;
+        contents->indexType = (header.indexStride == sizeof(uint16_t)) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        contents->vertexCount = static_cast<uint32_t>(header.vertexCount);
+        contents->indexCount = static_cast<uint32_t>(header.indexCount);
+        contents->lods.assign(mappedLods, mappedLods + header.lodCount);
+
+        contents->boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+        contents->boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+        contents->boundingSphereCenter = glm::vec3(header.boundingSphere[0], header.boundingSphere[1], header.boundingSphere[2]);
+        contents->boundingSphereRadius = header.boundingSphere[3];
+        contents->textureCoordinateTransform = glm::vec4(
+            header.textureCoordinateTransform[0],
+            header.textureCoordinateTransform[1],
+            header.textureCoordinateTransform[2],
+            header.textureCoordinateTransform[3]
+        );
+
+        return true;
+    }
+
+    bool writeMeshCache(const char *cachePath, const MeshCacheKey &key, const MeshCacheContents &contents)
+    {
+        MeshCacheHeader header = {};
+        header.indexStride = (contents.indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+        header.key = key;
+        header.vertexCount = contents.vertexCount;
+        header.indexCount = contents.indexCount;
+        header.lodCount = contents.lods.size();
+        header.vertexDataOffset = alignUp(sizeof(MeshCacheHeader), 16);
+        header.indexDataOffset = alignUp(header.vertexDataOffset + header.vertexCount * header.vertexStride, 16);
+        header.lodDataOffset = alignUp(header.indexDataOffset + header.indexCount * header.indexStride, 16);
+        header.boundsMin[0] = contents.boundsMin.x;
+        header.boundsMin[1] = contents.boundsMin.y;
+        header.boundsMin[2] = contents.boundsMin.z;
+        header.boundsMax[0] = contents.boundsMax.x;
+        header.boundsMax[1] = contents.boundsMax.y;
+        header.boundsMax[2] = contents.boundsMax.z;
+        header.boundingSphere[0] = contents.boundingSphereCenter.x;
+        header.boundingSphere[1] = contents.boundingSphereCenter.y;
+        header.boundingSphere[2] = contents.boundingSphereCenter.z;
+        header.boundingSphere[3] = contents.boundingSphereRadius;
+        header.textureCoordinateTransform[0] = contents.textureCoordinateTransform.x;
+        header.textureCoordinateTransform[1] = contents.textureCoordinateTransform.y;
+        header.textureCoordinateTransform[2] = contents.textureCoordinateTransform.z;
+        header.textureCoordinateTransform[3] = contents.textureCoordinateTransform.w;
+
+        std::vector<char> data(header.lodDataOffset + header.lodCount * sizeof(MeshLod), 0);
+        memcpy(data.data(), &header, sizeof(MeshCacheHeader));
+        memcpy(data.data() + header.vertexDataOffset, contents.vertices, header.vertexCount * header.vertexStride);
+        memcpy(data.data() + header.indexDataOffset, contents.indices, header.indexCount * header.indexStride);
+        memcpy(data.data() + header.lodDataOffset, contents.lods.data(), header.lodCount * sizeof(MeshLod));
+
+        return writeFileAtomically(cachePath, data.data(), data.size());
+    }
+} // namespace xr
@@ -0,0 +1,304 @@
+#include "meshOptimizer.h"
+
+#include <algorithm>
+
+namespace xr
+{
+    VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> &vertexIndices, size_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStatistics statistics = {};
+
+        if (vertexIndices.empty() || vertexCount == 0)
+        {
+            return statistics;
+        }
+
+        // A vertex is in the FIFO while fewer than cacheSize misses happened since it was loaded.
+        std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+        uint32_t timestamp = cacheSize + 1;
+        size_t missCount = 0;
+
+        for (uint32_t vertexIndex : vertexIndices)
+        {
+            if (timestamp - cacheTimestamps[vertexIndex] > cacheSize)
+            {
+                cacheTimestamps[vertexIndex] = timestamp++;
+                ++missCount;
+            }
+        }
+
+        statistics.acmr = static_cast<float>(missCount) / static_cast<float>(vertexIndices.size() / 3);
+        statistics.atvr = static_cast<float>(missCount) / static_cast<float>(vertexCount);
+
+        return statistics;
+    }
+
+    static int64_t skipDeadEnd(
+        const std::vector<uint32_t> &liveTriangleCounts,
+        std::vector<uint32_t> *deadEndStack,
+        size_t *vertexCursor
+    )
+    {
+        while (!deadEndStack->empty())
+        {
+            uint32_t vertexIndex = deadEndStack->back();
+            deadEndStack->pop_back();
+
+            if (liveTriangleCounts[vertexIndex] > 0)
+            {
+                return vertexIndex;
+            }
+        }
+
+        while (*vertexCursor < liveTriangleCounts.size())
+        {
+            if (liveTriangleCounts[*vertexCursor] > 0)
+            {
+                return static_cast<int64_t>(*vertexCursor);
+            }
+
+            ++*vertexCursor;
+        }
+
+        return -1;
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t> *vertexIndices, size_t vertexCount, uint32_t cacheSize)
+    {
+        size_t triangleCount = vertexIndices->size() / 3;
+
+        if (triangleCount == 0 || vertexCount == 0)
+        {
+            return;
+        }
+
+        // Vertex to triangle adjacency as offsets into one array.
+        std::vector<uint32_t> liveTriangleCounts(vertexCount, 0);
+
+        for (uint32_t vertexIndex : *vertexIndices)
+        {
+            ++liveTriangleCounts[vertexIndex];
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+
+        for (size_t counter = 0; counter < vertexCount; ++counter)
+        {
+            adjacencyOffsets[counter + 1] = adjacencyOffsets[counter] + liveTriangleCounts[counter];
+        }
+
+        std::vector<uint32_t> adjacency(vertexIndices->size());
+        std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t vertexIndex = (*vertexIndices)[triangle * 3 + corner];
+                adjacency[adjacencyFill[vertexIndex]++] = static_cast<uint32_t>(triangle);
+            }
+        }
+
+        std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+        std::vector<bool> isEmitted(triangleCount, false);
+        std::vector<uint32_t> deadEndStack;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(vertexIndices->size());
+
+        uint32_t timestamp = cacheSize + 1;
+        size_t vertexCursor = 0;
+        int64_t fanningVertex = 0;
+
+        while (fanningVertex >= 0)
+        {
+            candidates.clear();
+
+            for (uint32_t offset = adjacencyOffsets[fanningVertex]; offset < adjacencyOffsets[fanningVertex + 1]; ++offset)
+            {
+                uint32_t triangle = adjacency[offset];
+
+                if (isEmitted[triangle])
+                {
+                    continue;
+                }
+
+                for (size_t corner = 0; corner < 3; ++corner)
+                {
+                    uint32_t vertexIndex = (*vertexIndices)[triangle * 3 + corner];
+
+                    output.push_back(vertexIndex);
+                    deadEndStack.push_back(vertexIndex);
+                    candidates.push_back(vertexIndex);
+                    --liveTriangleCounts[vertexIndex];
+
+                    if (timestamp - cacheTimestamps[vertexIndex] > cacheSize)
+                    {
+                        cacheTimestamps[vertexIndex] = timestamp++;
+                    }
+                }
+
+                isEmitted[triangle] = true;
+            }
+
+            // Next fanning vertex is the candidate that stays longest in the cache after its remaining triangles are emitted.
+            int64_t nextVertex = -1;
+            int64_t bestPriority = -1;
+
+            for (uint32_t vertexIndex : candidates)
+            {
+                if (liveTriangleCounts[vertexIndex] == 0)
+                {
+                    continue;
+                }
+
+                int64_t priority = 0;
+
+                if (timestamp - cacheTimestamps[vertexIndex] + 2 * liveTriangleCounts[vertexIndex] <= cacheSize)
+                {
+                    priority = timestamp - cacheTimestamps[vertexIndex];
+                }
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    nextVertex = vertexIndex;
+                }
+            }
+
+            fanningVertex = (nextVertex >= 0) ? nextVertex : skipDeadEnd(liveTriangleCounts, &deadEndStack, &vertexCursor);
+        }
+
+        vertexIndices->swap(output);
+    }
+
+    void optimizeOverdraw(std::vector<uint32_t> *vertexIndices, const std::vector<Vertex> &vertices, uint32_t cacheSize)
+    {
+        size_t triangleCount = vertexIndices->size() / 3;
+
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // A cluster starts at every triangle whose three vertices all miss the cache, the points where Tipsify
+        // jumped to a new fan. Reordering whole clusters does not change the cache behaviour inside them.
+        std::vector<uint32_t> clusterStarts;
+        std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+        uint32_t timestamp = cacheSize + 1;
+
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            uint32_t missCount = 0;
+
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t vertexIndex = (*vertexIndices)[triangle * 3 + corner];
+
+                if (timestamp - cacheTimestamps[vertexIndex] > cacheSize)
+                {
+                    cacheTimestamps[vertexIndex] = timestamp++;
+                    ++missCount;
+                }
+            }
+
+            if (triangle == 0 || missCount == 3)
+            {
+                clusterStarts.push_back(static_cast<uint32_t>(triangle));
+            }
+        }
+
+        clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+        size_t clusterCount = clusterStarts.size() - 1;
+
+        if (clusterCount < 2)
+        {
+            return;
+        }
+
+        // Area weighted centroid and normal per cluster, and of the whole mesh.
+        std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+        std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+        glm::vec3 meshCentroid = glm::vec3(0.0f);
+        float meshArea = 0.0f;
+
+        for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+        {
+            float clusterArea = 0.0f;
+
+            for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+            {
+                const glm::vec3 &position0 = vertices[(*vertexIndices)[triangle * 3 + 0]].position;
+                const glm::vec3 &position1 = vertices[(*vertexIndices)[triangle * 3 + 1]].position;
+                const glm::vec3 &position2 = vertices[(*vertexIndices)[triangle * 3 + 2]].position;
+
+                glm::vec3 normal = glm::cross(position1 - position0, position2 - position0);
+                float area = glm::length(normal) * 0.5f;
+                glm::vec3 centroid = (position0 + position1 + position2) / 3.0f;
+
+                clusterCentroids[cluster] += centroid * area;
+                clusterNormals[cluster] += normal;
+                clusterArea += area;
+            }
+
+            meshCentroid += clusterCentroids[cluster];
+            meshArea += clusterArea;
+
+            clusterCentroids[cluster] = (clusterArea > 0.0f) ? clusterCentroids[cluster] / clusterArea : clusterCentroids[cluster];
+        }
+
+        meshCentroid = (meshArea > 0.0f) ? meshCentroid / meshArea : meshCentroid;
+
+        // Clusters facing away from the mesh centre are likely to occlude the ones behind them, draw them first.
+        std::vector<float> sortKeys(clusterCount, 0.0f);
+        std::vector<uint32_t> clusterOrder(clusterCount);
+
+        for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+        {
+            float normalLength = glm::length(clusterNormals[cluster]);
+            glm::vec3 normal = (normalLength > 0.0f) ? clusterNormals[cluster] / normalLength : glm::vec3(0.0f);
+
+            sortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid, normal);
+            clusterOrder[cluster] = static_cast<uint32_t>(cluster);
+        }
+
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t left, uint32_t right) {
+            return sortKeys[left] > sortKeys[right];
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(vertexIndices->size());
+
+        for (uint32_t cluster : clusterOrder)
+        {
+            output.insert(
+                output.end(),
+                vertexIndices->begin() + clusterStarts[cluster] * 3,
+                vertexIndices->begin() + clusterStarts[cluster + 1] * 3
+            );
+        }
+
+        vertexIndices->swap(output);
+    }
+
+    void optimizeVertexFetch(std::vector<Vertex> *vertices, std::vector<uint32_t> *vertexIndices)
+    {
+        std::vector<uint32_t> remap(vertices->size(), UINT32_MAX);
+        std::vector<Vertex> output;
+        output.reserve(vertices->size());
+
+        for (uint32_t &vertexIndex : *vertexIndices)
+        {
+            if (remap[vertexIndex] == UINT32_MAX)
+            {
+                remap[vertexIndex] = static_cast<uint32_t>(output.size());
+                output.push_back((*vertices)[vertexIndex]);
+            }
+
+            vertexIndex = remap[vertexIndex];
+        }
+
+        vertices->swap(output);
+    }
+} // namespace xr
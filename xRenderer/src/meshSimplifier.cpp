@@ -0,0 +1,359 @@
+#include "meshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace xr
+{
+    // Maximum number of collapse passes, each pass collapses an independent set of edges.
+    static const uint32_t MAX_SIMPLIFY_PASSES = 64;
+
+    // Symmetric 4x4 matrix of the plane equations around a vertex, weighted by triangle area.
+    struct Quadric {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+        double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+        double a22 = 0.0, a23 = 0.0;
+        double a33 = 0.0;
+        double weight = 0.0;
+
+        void add(const Quadric &other)
+        {
+            this->a00 += other.a00; this->a01 += other.a01; this->a02 += other.a02; this->a03 += other.a03;
+            this->a11 += other.a11; this->a12 += other.a12; this->a13 += other.a13;
+            this->a22 += other.a22; this->a23 += other.a23;
+            this->a33 += other.a33;
+            this->weight += other.weight;
+        }
+
+        // Mean squared distance of position to the accumulated planes.
+        double evaluate(const glm::vec3 &position) const
+        {
+            double x = position.x, y = position.y, z = position.z;
+            double result = this->a00 * x * x + 2.0 * this->a01 * x * y + 2.0 * this->a02 * x * z + 2.0 * this->a03 * x
+                          + this->a11 * y * y + 2.0 * this->a12 * y * z + 2.0 * this->a13 * y
+                          + this->a22 * z * z + 2.0 * this->a23 * z
+                          + this->a33;
+
+            return (this->weight > 0.0) ? std::max(result, 0.0) / this->weight : 0.0;
+        }
+    };
+
+    static Quadric makePlaneQuadric(const glm::vec3 &position0, const glm::vec3 &position1, const glm::vec3 &position2)
+    {
+        Quadric quadric = {};
+        glm::dvec3 normal = glm::cross(glm::dvec3(position1 - position0), glm::dvec3(position2 - position0));
+        double length = glm::length(normal);
+
+        if (length == 0.0)
+        {
+            return quadric;
+        }
+
+        double area = length * 0.5;
+        normal /= length;
+        double distance = -glm::dot(normal, glm::dvec3(position0));
+
+        quadric.a00 = area * normal.x * normal.x;
+        quadric.a01 = area * normal.x * normal.y;
+        quadric.a02 = area * normal.x * normal.z;
+        quadric.a03 = area * normal.x * distance;
+        quadric.a11 = area * normal.y * normal.y;
+        quadric.a12 = area * normal.y * normal.z;
+        quadric.a13 = area * normal.y * distance;
+        quadric.a22 = area * normal.z * normal.z;
+        quadric.a23 = area * normal.z * distance;
+        quadric.a33 = area * distance * distance;
+        quadric.weight = area;
+
+        return quadric;
+    }
+
+    struct EdgeCollapse {
+        uint32_t from = 0;
+        uint32_t to = 0;
+        double cost = 0.0;
+    };
+
+    // Vertices that share a position with another vertex (UV seams) or lie on an open edge must keep their place,
+    // moving them would tear the surface.
+    static std::vector<bool> findLockedVertices(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &vertexIndices)
+    {
+        std::vector<bool> isLocked(vertices.size(), false);
+        std::vector<uint32_t> order(vertices.size());
+
+        for (uint32_t index = 0; index < order.size(); ++index)
+        {
+            order[index] = index;
+        }
+
+        auto positionLess = [&vertices](uint32_t left, uint32_t right) {
+            const glm::vec3 &a = vertices[left].position;
+            const glm::vec3 &b = vertices[right].position;
+            return (a.x != b.x) ? a.x < b.x : (a.y != b.y) ? a.y < b.y : a.z < b.z;
+        };
+
+        std::sort(order.begin(), order.end(), positionLess);
+
+        for (size_t index = 1; index < order.size(); ++index)
+        {
+            if (vertices[order[index]].position == vertices[order[index - 1]].position)
+            {
+                isLocked[order[index]] = true;
+                isLocked[order[index - 1]] = true;
+            }
+        }
+
+        // An undirected edge used by exactly one triangle is a border.
+        std::vector<uint64_t> edges;
+        edges.reserve(vertexIndices.size());
+
+        for (size_t triangle = 0; triangle < vertexIndices.size() / 3; ++triangle)
+        {
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                uint64_t a = vertexIndices[triangle * 3 + corner];
+                uint64_t b = vertexIndices[triangle * 3 + (corner + 1) % 3];
+                edges.push_back((std::min(a, b) << 32) | std::max(a, b));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+
+        for (size_t index = 0; index < edges.size();)
+        {
+            size_t end = index + 1;
+
+            while (end < edges.size() && edges[end] == edges[index])
+            {
+                ++end;
+            }
+
+            if (end - index == 1)
+            {
+                isLocked[edges[index] >> 32] = true;
+                isLocked[edges[index] & UINT32_MAX] = true;
+            }
+
+            index = end;
+        }
+
+        return isLocked;
+    }
+
+    // Rejects the collapse if a remaining triangle around from would turn over or become degenerate.
+    static bool isCollapseValid(
+        const std::vector<Vertex> &vertices,
+        const std::vector<uint32_t> &indices,
+        const std::vector<uint32_t> &adjacencyOffsets,
+        const std::vector<uint32_t> &adjacency,
+        uint32_t from,
+        uint32_t to
+    )
+    {
+        for (uint32_t offset = adjacencyOffsets[from]; offset < adjacencyOffsets[from + 1]; ++offset)
+        {
+            uint32_t triangle = adjacency[offset];
+            uint32_t corners[3] = { indices[triangle * 3 + 0], indices[triangle * 3 + 1], indices[triangle * 3 + 2] };
+
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+            {
+                continue;
+            }
+
+            glm::vec3 positions[3];
+            glm::vec3 movedPositions[3];
+
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                positions[corner] = vertices[corners[corner]].position;
+                movedPositions[corner] = vertices[(corners[corner] == from) ? to : corners[corner]].position;
+            }
+
+            glm::vec3 normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+            glm::vec3 movedNormal = glm::cross(movedPositions[1] - movedPositions[0], movedPositions[2] - movedPositions[0]);
+
+            // Also catches the moved triangle becoming a sliver.
+            if (glm::dot(normal, movedNormal) <= 0.25f * glm::length(normal) * glm::length(movedNormal) || glm::length(movedNormal) == 0.0f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::vector<uint32_t> simplifyMesh(
+        const std::vector<Vertex> &vertices,
+        const std::vector<uint32_t> &vertexIndices,
+        size_t targetIndexCount,
+        float *error
+    )
+    {
+        std::vector<uint32_t> indices = vertexIndices;
+        *error = 0.0f;
+
+        if (indices.size() <= targetIndexCount || vertices.empty())
+        {
+            return indices;
+        }
+
+        std::vector<bool> isLocked = findLockedVertices(vertices, indices);
+        std::vector<Quadric> quadrics(vertices.size());
+
+        for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle)
+        {
+            uint32_t a = indices[triangle * 3 + 0];
+            uint32_t b = indices[triangle * 3 + 1];
+            uint32_t c = indices[triangle * 3 + 2];
+
+            Quadric quadric = makePlaneQuadric(vertices[a].position, vertices[b].position, vertices[c].position);
+            quadrics[a].add(quadric);
+            quadrics[b].add(quadric);
+            quadrics[c].add(quadric);
+        }
+
+        std::vector<EdgeCollapse> collapses;
+        std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<bool> isTouched(vertices.size());
+        double maxCost = 0.0;
+
+        for (uint32_t pass = 0; pass < MAX_SIMPLIFY_PASSES && indices.size() > targetIndexCount; ++pass)
+        {
+            size_t triangleCount = indices.size() / 3;
+
+            // Vertex to triangle adjacency of the current indices.
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+
+            for (uint32_t vertexIndex : indices)
+            {
+                ++adjacencyOffsets[vertexIndex + 1];
+            }
+
+            for (size_t index = 1; index < adjacencyOffsets.size(); ++index)
+            {
+                adjacencyOffsets[index] += adjacencyOffsets[index - 1];
+            }
+
+            adjacency.resize(indices.size());
+            std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+            for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+            {
+                for (size_t corner = 0; corner < 3; ++corner)
+                {
+                    adjacency[adjacencyFill[indices[triangle * 3 + corner]]++] = static_cast<uint32_t>(triangle);
+                }
+            }
+
+            // Every directed edge whose start can move, the cost is the merged quadric at the end position.
+            collapses.clear();
+
+            for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+            {
+                for (size_t corner = 0; corner < 3; ++corner)
+                {
+                    uint32_t from = indices[triangle * 3 + corner];
+                    uint32_t to = indices[triangle * 3 + (corner + 1) % 3];
+
+                    for (uint32_t direction = 0; direction < 2; ++direction, std::swap(from, to))
+                    {
+                        if (isLocked[from])
+                        {
+                            continue;
+                        }
+
+                        Quadric merged = quadrics[from];
+                        merged.add(quadrics[to]);
+
+                        EdgeCollapse collapse = {};
+                        collapse.from = from;
+                        collapse.to = to;
+                        collapse.cost = merged.evaluate(vertices[to].position);
+                        collapses.push_back(collapse);
+                    }
+                }
+            }
+
+            if (collapses.empty())
+            {
+                break;
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse &left, const EdgeCollapse &right) {
+                return left.cost < right.cost;
+            });
+
+            // Each collapse removes about two triangles, stop once enough are planned for this pass.
+            size_t collapseBudget = std::max<size_t>((triangleCount - targetIndexCount / 3) / 2, 1);
+            size_t collapseCount = 0;
+
+            for (uint32_t index = 0; index < remap.size(); ++index)
+            {
+                remap[index] = index;
+            }
+
+            std::fill(isTouched.begin(), isTouched.end(), false);
+
+            for (const EdgeCollapse &collapse : collapses)
+            {
+                if (collapseCount >= collapseBudget)
+                {
+                    break;
+                }
+
+                if (isTouched[collapse.from] || isTouched[collapse.to])
+                {
+                    continue;
+                }
+
+                if (!isCollapseValid(vertices, indices, adjacencyOffsets, adjacency, collapse.from, collapse.to))
+                {
+                    continue;
+                }
+
+                // The neighbourhood of from changes shape, no other collapse may touch it in this pass.
+                for (uint32_t offset = adjacencyOffsets[collapse.from]; offset < adjacencyOffsets[collapse.from + 1]; ++offset)
+                {
+                    uint32_t triangle = adjacency[offset];
+                    isTouched[indices[triangle * 3 + 0]] = true;
+                    isTouched[indices[triangle * 3 + 1]] = true;
+                    isTouched[indices[triangle * 3 + 2]] = true;
+                }
+
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to].add(quadrics[collapse.from]);
+                maxCost = std::max(maxCost, collapse.cost);
+                ++collapseCount;
+            }
+
+            if (collapseCount == 0)
+            {
+                break;
+            }
+
+            // Apply the collapses and drop triangles that lost an edge.
+            size_t writeIndex = 0;
+
+            for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+            {
+                uint32_t a = remap[indices[triangle * 3 + 0]];
+                uint32_t b = remap[indices[triangle * 3 + 1]];
+                uint32_t c = remap[indices[triangle * 3 + 2]];
+
+                if (a != b && b != c && a != c)
+                {
+                    indices[writeIndex++] = a;
+                    indices[writeIndex++] = b;
+                    indices[writeIndex++] = c;
+                }
+            }
+
+            indices.resize(writeIndex);
+        }
+
+        *error = static_cast<float>(std::sqrt(maxCost));
+        return indices;
+    }
+} // namespace xr
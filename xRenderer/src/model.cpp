@@ -6,11 +6,452 @@
 #include "lib/tinyobj/tiny_obj_loader.h"
 
 #include "model.h"
+#include "meshCache.h"
+#include "objParser.h"
+#include "vertexWelder.h"
 #include "utils.h"
 
 namespace xr
 {
-    Model::Model(const char *modelFilePath)
+#if ENABLE_OBJ_PARSER_VALIDATION
+    // Logs the first difference between the chunked parser's and tinyobj's welded output.
+    static bool compareObjParserOutput(
+        const char *modelFilePath,
+        const std::vector<Vertex> &parsedVertices,
+        const std::vector<uint32_t> &parsedVertexIndices,
+        const std::vector<Vertex> &referenceVertices,
+        const std::vector<uint32_t> &referenceVertexIndices
+    )
+    {
+        if (parsedVertices.size() != referenceVertices.size() || parsedVertexIndices.size() != referenceVertexIndices.size())
+        {
+            logf(
+                "[OBJ] %s: %zu vertices and %zu indices, tinyobj %zu vertices and %zu indices",
+                modelFilePath,
+                parsedVertices.size(),
+                parsedVertexIndices.size(),
+                referenceVertices.size(),
+                referenceVertexIndices.size()
+            );
+            return false;
+        }
+
+        for (size_t index = 0; index < parsedVertices.size(); ++index)
+        {
+            const Vertex &parsed = parsedVertices[index];
+            const Vertex &reference = referenceVertices[index];
+
+            if (parsed.position != reference.position)
+            {
+                logf(
+                    "[OBJ] %s: vertex %zu position (%f, %f, %f), tinyobj (%f, %f, %f)",
+                    modelFilePath,
+                    index,
+                    parsed.position.x,
+                    parsed.position.y,
+                    parsed.position.z,
+                    reference.position.x,
+                    reference.position.y,
+                    reference.position.z
+                );
+                return false;
+            }
+
+            if (parsed.textureCoordinates != reference.textureCoordinates)
+            {
+                logf(
+                    "[OBJ] %s: vertex %zu texture coordinates (%f, %f), tinyobj (%f, %f)",
+                    modelFilePath,
+                    index,
+                    parsed.textureCoordinates.x,
+                    parsed.textureCoordinates.y,
+                    reference.textureCoordinates.x,
+                    reference.textureCoordinates.y
+                );
+                return false;
+            }
+
+            if (parsed.color != reference.color)
+            {
+                logf("[OBJ] %s: vertex %zu color differs from tinyobj", modelFilePath, index);
+                return false;
+            }
+        }
+
+        for (size_t index = 0; index < parsedVertexIndices.size(); ++index)
+        {
+            if (parsedVertexIndices[index] != referenceVertexIndices[index])
+            {
+                logf("[OBJ] %s: index %zu is %u, tinyobj %u", modelFilePath, index, parsedVertexIndices[index], referenceVertexIndices[index]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+#endif
+
+    static glm::vec3 getPositionExtent(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+    {
+        // A flat axis still needs a non zero scale to divide by.
+        glm::vec3 positionExtent = boundsMax - boundsMin;
+
+        return glm::vec3(
+            positionExtent.x > 0.0f ? positionExtent.x : 1.0f,
+            positionExtent.y > 0.0f ? positionExtent.y : 1.0f,
+            positionExtent.z > 0.0f ? positionExtent.z : 1.0f
+        );
+    }
+
+    static glm::mat4 getPositionDequantization(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+    {
+        return glm::scale(glm::translate(glm::mat4(1.0f), boundsMin), getPositionExtent(boundsMin, boundsMax));
+    }
+
+    Model::Model(const char *modelFilePath, const ModelLoadOptions &loadOptions)
+    {
+        float weldTolerance = loadOptions.weldTolerance;
+        uint32_t optimizationFlags = loadOptions.optimizationFlags;
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        std::string cachePath = getMeshCachePath(modelFilePath);
+
+        MeshCacheKey cacheKey = {};
+        cacheKey.weldTolerance = weldTolerance;
+        cacheKey.optimizationFlags = optimizationFlags;
+        cacheKey.maxLodCount = loadOptions.maxLodCount;
+
+        // Only read when the cache cannot be used, or when the cache needed the whole file to decide.
+        std::vector<char> data;
+
+#if ENABLE_MESH_CACHE
+        // A warm load never reads the OBJ, the packed mesh is uploaded from the mapped cache as is.
+        std::unique_ptr<MappedFile> cacheFile(new MappedFile());
+        MeshCacheContents cacheContents;
+
+        if (readMeshSourceStamp(modelFilePath, &cacheKey) && readMeshCache(cachePath.c_str(), modelFilePath, cacheKey, cacheFile.get(), &cacheContents, &data))
+        {
+            this->lods = std::move(cacheContents.lods);
+            this->boundsMin = cacheContents.boundsMin;
+            this->boundsMax = cacheContents.boundsMax;
+            this->boundingSphereCenter = cacheContents.boundingSphereCenter;
+            this->boundingSphereRadius = cacheContents.boundingSphereRadius;
+            this->positionDequantization = getPositionDequantization(this->boundsMin, this->boundsMax);
+            this->textureCoordinateTransform = cacheContents.textureCoordinateTransform;
+            this->indexType = cacheContents.indexType;
+            this->packedVertices = cacheContents.vertices;
+            this->packedIndices = cacheContents.indices;
+            this->vertexCount = cacheContents.vertexCount;
+            this->indexCount = cacheContents.indexCount;
+            this->meshCacheFile = std::move(cacheFile);
+
+            auto endTime = std::chrono::high_resolution_clock::now();
+            float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+
+            logf("[OBJ] %s: loaded from mesh cache, %d unique vertices, %zu LODs, %f ms", modelFilePath, this->vertexCount, this->lods.size(), loadTime);
+            return;
+        }
+#endif
+
+        bool isRead = !data.empty() || readFile(modelFilePath, &data);
+        size_t sourceSize = data.size();
+
+#if ENABLE_MESH_CACHE
+        // The stamp is taken again, a file changed since the lookup must not be cached under the old one.
+        cacheKey.sourceHash = hashBytes(data.data(), data.size());
+        bool isCacheable = isRead && readMeshSourceStamp(modelFilePath, &cacheKey) && cacheKey.sourceSize == sourceSize;
+#endif
+
+        ObjParserStatistics statistics = {};
+        bool isParsed = false;
+
+        if (isRead)
+        {
+            data.push_back('\0');
+            isParsed = parseObjData(data.data(), sourceSize, 0, weldTolerance, &this->vertices, &this->vertexIndices, &statistics);
+        }
+
+        if (!isParsed)
+        {
+            this->vertices.clear();
+            this->vertexIndices.clear();
+
+            // Runs on streamer worker threads, an empty model lets AssetStreamer report the asset as FAILED.
+            if (!this->loadWithTinyObj(modelFilePath, weldTolerance))
+            {
+                this->vertices.clear();
+                this->vertexIndices.clear();
+                return;
+            }
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        float parseTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+
+        if (isParsed)
+        {
+            logf(
+                "[OBJ] %s: %zu bytes in %d chunks, %zu triangles, %zu unique vertices, %f ms",
+                modelFilePath,
+                statistics.fileSize,
+                statistics.chunkCount,
+                statistics.triangleCount,
+                this->vertices.size(),
+                parseTime
+            );
+        }
+        else
+        {
+            logf("[OBJ] %s: parsed by tinyobj, %zu unique vertices, %f ms", modelFilePath, this->vertices.size(), parseTime);
+        }
+
+#if ENABLE_OBJ_PARSER_VALIDATION
+        // Imports only, a mesh cache hit never runs a parser. The chunked parser's output is kept.
+        if (isParsed)
+        {
+            std::vector<Vertex> parsedVertices;
+            std::vector<uint32_t> parsedVertexIndices;
+            parsedVertices.swap(this->vertices);
+            parsedVertexIndices.swap(this->vertexIndices);
+
+            bool isMatching = this->loadWithTinyObj(modelFilePath, weldTolerance)
+                           && compareObjParserOutput(modelFilePath, parsedVertices, parsedVertexIndices, this->vertices, this->vertexIndices);
+
+            logf("[OBJ] %s: chunked parser %s tinyobj", modelFilePath, isMatching ? "matches" : "DOES NOT match");
+            assert(isMatching && "Chunked OBJ parser output differs from tinyobj.");
+
+            this->vertices.swap(parsedVertices);
+            this->vertexIndices.swap(parsedVertexIndices);
+        }
+#endif
+
+#if ENABLE_VERTEX_WELD_BENCHMARK
+        benchmarkVertexWelding(modelFilePath, this->vertices, this->vertexIndices);
+#endif
+
+        this->optimize(modelFilePath, optimizationFlags);
+        this->generateLods(modelFilePath, loadOptions.maxLodCount, optimizationFlags);
+        this->updateBounds();
+        this->updateBoundingSphere();
+        this->pack();
+
+#if ENABLE_MESH_CACHE
+        if (isCacheable)
+        {
+            MeshCacheContents contents;
+            contents.vertices = this->packedVertices;
+            contents.indices = this->packedIndices;
+            contents.indexType = this->indexType;
+            contents.vertexCount = this->vertexCount;
+            contents.indexCount = this->indexCount;
+            contents.lods = this->lods;
+            contents.boundsMin = this->boundsMin;
+            contents.boundsMax = this->boundsMax;
+            contents.boundingSphereCenter = this->boundingSphereCenter;
+            contents.boundingSphereRadius = this->boundingSphereRadius;
+            contents.textureCoordinateTransform = this->textureCoordinateTransform;
+
+            if (!writeMeshCache(cachePath.c_str(), cacheKey, contents))
+            {
+                logf("[OBJ] %s: unable to write mesh cache %s", modelFilePath, cachePath.c_str());
+            }
+        }
+#endif
+    }
+
+    void Model::optimize(const char *modelFilePath, uint32_t optimizationFlags)
+    {
+        if (!(optimizationFlags & MESH_OPTIMIZATION_VERTEX_CACHE_BIT))
+        {
+            return;
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        VertexCacheStatistics statisticsBefore = analyzeVertexCache(this->vertexIndices, this->vertices.size(), VERTEX_CACHE_SIZE);
+
+        optimizeVertexCache(&this->vertexIndices, this->vertices.size(), VERTEX_CACHE_SIZE);
+
+        if (optimizationFlags & MESH_OPTIMIZATION_OVERDRAW_BIT)
+        {
+            optimizeOverdraw(&this->vertexIndices, this->vertices, VERTEX_CACHE_SIZE);
+        }
+
+        optimizeVertexFetch(&this->vertices, &this->vertexIndices);
+
+        VertexCacheStatistics statisticsAfter = analyzeVertexCache(this->vertexIndices, this->vertices.size(), VERTEX_CACHE_SIZE);
+        auto endTime = std::chrono::high_resolution_clock::now();
+        float optimizeTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+
+        logf(
+            "[OBJ] %s: ACMR %f -> %f, ATVR %f -> %f, overdraw ordering %s, %f ms",
+            modelFilePath,
+            statisticsBefore.acmr,
+            statisticsAfter.acmr,
+            statisticsBefore.atvr,
+            statisticsAfter.atvr,
+            (optimizationFlags & MESH_OPTIMIZATION_OVERDRAW_BIT) ? "on" : "off",
+            optimizeTime
+        );
+    }
+
+    void Model::generateLods(const char *modelFilePath, uint32_t maxLodCount, uint32_t optimizationFlags)
+    {
+        MeshLod fullLod = {};
+        fullLod.indexCount = static_cast<uint32_t>(this->vertexIndices.size());
+        this->lods.assign(1, fullLod);
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<uint32_t> previousIndices = this->vertexIndices;
+        float accumulatedError = 0.0f;
+
+        // Every level halves the triangles of the previous one, simplifying the previous level instead of LOD 0
+        // keeps each step cheap and the errors are summed into a conservative bound.
+        while (this->lods.size() < maxLodCount)
+        {
+            size_t targetIndexCount = (previousIndices.size() / 6) * 3;
+            float error = 0.0f;
+            std::vector<uint32_t> lodIndices = simplifyMesh(this->vertices, previousIndices, targetIndexCount, &error);
+
+            // Locked seams and borders can stall the simplifier, a level that barely shrinks is not worth a draw range.
+            if (lodIndices.empty() || lodIndices.size() * 10 > previousIndices.size() * 9)
+            {
+                break;
+            }
+
+            if (optimizationFlags & MESH_OPTIMIZATION_VERTEX_CACHE_BIT)
+            {
+                optimizeVertexCache(&lodIndices, this->vertices.size(), VERTEX_CACHE_SIZE);
+            }
+
+            accumulatedError += error;
+
+            MeshLod lod = {};
+            lod.firstIndex = static_cast<uint32_t>(this->vertexIndices.size());
+            lod.indexCount = static_cast<uint32_t>(lodIndices.size());
+            lod.error = accumulatedError;
+            this->lods.push_back(lod);
+
+            this->vertexIndices.insert(this->vertexIndices.end(), lodIndices.begin(), lodIndices.end());
+            previousIndices.swap(lodIndices);
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        float simplifyTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+
+        for (size_t level = 0; level < this->lods.size(); ++level)
+        {
+            logf(
+                "[OBJ] %s: LOD %zu, %u triangles, error %f",
+                modelFilePath,
+                level,
+                this->lods[level].indexCount / 3,
+                this->lods[level].error
+            );
+        }
+
+        logf("[OBJ] %s: %zu LODs generated in %f ms", modelFilePath, this->lods.size(), simplifyTime);
+    }
+
+    static inline uint16_t quantizeUnorm16(float value)
+    {
+        return static_cast<uint16_t>(std::floor(glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f));
+    }
+
+    void Model::pack()
+    {
+        glm::vec3 positionExtent = getPositionExtent(this->boundsMin, this->boundsMax);
+
+        glm::vec2 textureCoordinateMin = glm::vec2(0.0f);
+        glm::vec2 textureCoordinateMax = glm::vec2(1.0f);
+
+        if (!this->vertices.empty())
+        {
+            textureCoordinateMin = this->vertices[0].textureCoordinates;
+            textureCoordinateMax = this->vertices[0].textureCoordinates;
+
+            for (const Vertex &vertex : this->vertices)
+            {
+                textureCoordinateMin = glm::min(textureCoordinateMin, vertex.textureCoordinates);
+                textureCoordinateMax = glm::max(textureCoordinateMax, vertex.textureCoordinates);
+            }
+        }
+
+        glm::vec2 textureCoordinateExtent = textureCoordinateMax - textureCoordinateMin;
+        textureCoordinateExtent = glm::vec2(
+            textureCoordinateExtent.x > 0.0f ? textureCoordinateExtent.x : 1.0f,
+            textureCoordinateExtent.y > 0.0f ? textureCoordinateExtent.y : 1.0f
+        );
+
+        this->positionDequantization = getPositionDequantization(this->boundsMin, this->boundsMax);
+        this->textureCoordinateTransform = glm::vec4(textureCoordinateExtent, textureCoordinateMin);
+
+        this->compactVertices.resize(this->vertices.size());
+
+        for (size_t index = 0; index < this->vertices.size(); ++index)
+        {
+            glm::vec3 position = (this->vertices[index].position - this->boundsMin) / positionExtent;
+            glm::vec2 textureCoordinates = (this->vertices[index].textureCoordinates - textureCoordinateMin) / textureCoordinateExtent;
+
+            CompactVertex &compactVertex = this->compactVertices[index];
+            compactVertex.position[0] = quantizeUnorm16(position.x);
+            compactVertex.position[1] = quantizeUnorm16(position.y);
+            compactVertex.position[2] = quantizeUnorm16(position.z);
+            compactVertex.position[3] = 0;
+            compactVertex.textureCoordinates[0] = quantizeUnorm16(textureCoordinates.x);
+            compactVertex.textureCoordinates[1] = quantizeUnorm16(textureCoordinates.y);
+        }
+
+        this->compactVertexIndices.clear();
+        this->indexType = VK_INDEX_TYPE_UINT32;
+
+        if (this->vertices.size() <= 65536)
+        {
+            this->compactVertexIndices.assign(this->vertexIndices.begin(), this->vertexIndices.end());
+            this->indexType = VK_INDEX_TYPE_UINT16;
+        }
+
+        this->packedVertices = this->compactVertices.data();
+        this->packedIndices = (this->indexType == VK_INDEX_TYPE_UINT16) ? static_cast<const void *>(this->compactVertexIndices.data())
+                                                                        : static_cast<const void *>(this->vertexIndices.data());
+        this->vertexCount = static_cast<uint32_t>(this->compactVertices.size());
+        this->indexCount = static_cast<uint32_t>(this->vertexIndices.size());
+    }
+
+    void Model::updateBounds()
+    {
+        if (this->vertices.empty())
+        {
+            this->boundsMin = glm::vec3(0.0f);
+            this->boundsMax = glm::vec3(0.0f);
+            return;
+        }
+
+        this->boundsMin = this->vertices[0].position;
+        this->boundsMax = this->vertices[0].position;
+
+        for (const Vertex &vertex : this->vertices)
+        {
+            this->boundsMin = glm::min(this->boundsMin, vertex.position);
+            this->boundsMax = glm::max(this->boundsMax, vertex.position);
+        }
+    }
+
+    void Model::updateBoundingSphere()
+    {
+        // Centring on the box and measuring the farthest vertex is never looser than the box diagonal.
+        this->boundingSphereCenter = (this->boundsMin + this->boundsMax) * 0.5f;
+        float radiusSquared = 0.0f;
+
+        for (const Vertex &vertex : this->vertices)
+        {
+            glm::vec3 offset = vertex.position - this->boundingSphereCenter;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+
+        this->boundingSphereRadius = std::sqrt(radiusSquared);
+    }
+
+    bool Model::loadWithTinyObj(const char *modelFilePath, float weldTolerance)
     {
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
@@ -22,10 +463,18 @@ namespace xr
         if (!loaded)
         {
             logf("Model load error: %s", error.c_str());
-            assert(0 && "Not able to load model.");
+            return false;
+        }
+
+        size_t indexCount = 0;
+
+        for (const tinyobj::shape_t &nextShape : shapes)
+        {
+            indexCount += nextShape.mesh.indices.size();
         }
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+        VertexWelder welder(&this->vertices, indexCount, weldTolerance);
+        this->vertexIndices.reserve(indexCount);
 
         for (const tinyobj::shape_t &nextShape : shapes)
         {
@@ -40,23 +489,38 @@ namespace xr
 
                 };
 
-                nextVertex.textureCoordinates = { // the attrib.texcoords array is an array of float values instead of something like glm::vec2,
-                                                  // so you need to multiply the index by 2 to create group of 2 values.
-                                                  attrib.texcoords[2 * nextIndex.texcoord_index + 0],
-                                                  1.0 - attrib.texcoords[2 * nextIndex.texcoord_index + 1]
-                };
-
-                nextVertex.color = { 1.0f, 1.0f, 1.0f };
-
-                if (uniqueVertices.count(nextVertex) == 0)
+                // Faces without texture coordinates are the ones the chunked parser refuses, they get a zero UV.
+                if (nextIndex.texcoord_index >= 0)
                 {
-                    uniqueVertices[nextVertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(nextVertex);
+                    nextVertex.textureCoordinates = { // the attrib.texcoords array is an array of float values instead of something like glm::vec2,
+                                                      // so you need to multiply the index by 2 to create group of 2 values.
+                                                      attrib.texcoords[2 * nextIndex.texcoord_index + 0],
+                                                      1.0 - attrib.texcoords[2 * nextIndex.texcoord_index + 1]
+                    };
                 }
+                else
+                {
+                    nextVertex.textureCoordinates = { 0.0f, 0.0f };
+                }
+
+                nextVertex.color = { 1.0f, 1.0f, 1.0f };
 
-                vertexIndices.push_back(uniqueVertices[nextVertex]);
+                vertexIndices.push_back(welder.weld(nextVertex));
             }
         }
+
+        return true;
+    }
+
+    Model::Model(const Model *instanceSource)
+    {
+        // Instances of an instance share the original mesh.
+        this->instanceSource = instanceSource->getMeshSource();
+    }
+
+    const Model *Model::getMeshSource() const
+    {
+        return (this->instanceSource != nullptr) ? this->instanceSource : this;
     }
 
     Model::~Model()
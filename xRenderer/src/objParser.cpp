@@ -0,0 +1,511 @@
+#include "objParser.h"
+#include "vertexWelder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace xr
+{
+    // Smallest chunk worth a thread of its own, smaller files are parsed on the calling thread.
+    static const size_t MIN_CHUNK_SIZE = 512 * 1024;
+
+    // Index is relative to the number of elements read before the line, resolved against the chunk base on merge.
+    static const uint8_t RELATIVE_POSITION_INDEX = 1 << 0;
+    static const uint8_t RELATIVE_TEXTURE_COORDINATE_INDEX = 1 << 1;
+
+    struct ObjCorner {
+        int32_t positionIndex = 0;
+        int32_t textureCoordinateIndex = 0;
+        uint8_t flags = 0;
+    };
+
+    struct ObjChunk {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+
+        std::vector<float> positions;
+        std::vector<float> textureCoordinates;
+
+        // Already triangulated, three corners per triangle in file order.
+        std::vector<ObjCorner> corners;
+
+        bool hasMaterial = false;
+        bool hasGroupAfterMaterial = false;
+        bool hasGroup = false;
+        bool isSupported = true;
+    };
+
+    static inline bool isSpace(char character)
+    {
+        return character == ' ' || character == '\t';
+    }
+
+    static inline bool isLineEnd(char character)
+    {
+        return character == '\n' || character == '\r' || character == '\0';
+    }
+
+    static inline bool isDigit(char character)
+    {
+        return static_cast<unsigned int>(character - '0') < 10u;
+    }
+
+    static inline const char *skipSpaces(const char *token)
+    {
+        while (isSpace(*token))
+        {
+            ++token;
+        }
+
+        return token;
+    }
+
+    static inline const char *skipToken(const char *token, bool stopAtSlash)
+    {
+        while (!isSpace(*token) && !isLineEnd(*token) && !(stopAtSlash && *token == '/'))
+        {
+            ++token;
+        }
+
+        return token;
+    }
+
+    // Same accumulation order as tinyobj's tryParseDouble, so both paths produce bit identical floats.
+    static bool parseDouble(const char *begin, const char *end, double *result)
+    {
+        static const double powerLookup[] = { 1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001 };
+        static const int powerLookupSize = sizeof(powerLookup) / sizeof(powerLookup[0]);
+
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        const char *current = begin;
+        double mantissa = 0.0;
+        int exponent = 0;
+        int readCount = 0;
+        bool isNegative = false;
+
+        if (*current == '+' || *current == '-')
+        {
+            isNegative = (*current == '-');
+            ++current;
+        }
+        else if (!isDigit(*current))
+        {
+            return false;
+        }
+
+        while (current != end && isDigit(*current))
+        {
+            mantissa *= 10;
+            mantissa += static_cast<int>(*current - '0');
+            ++current;
+            ++readCount;
+        }
+
+        if (readCount == 0)
+        {
+            return false;
+        }
+
+        if (current != end && *current == '.')
+        {
+            ++current;
+            readCount = 1;
+
+            while (current != end && isDigit(*current))
+            {
+                mantissa += static_cast<int>(*current - '0') * (readCount < powerLookupSize ? powerLookup[readCount] : std::pow(10.0, -readCount));
+                ++readCount;
+                ++current;
+            }
+        }
+
+        if (current != end && (*current == 'e' || *current == 'E'))
+        {
+            ++current;
+            bool isExponentNegative = false;
+
+            if (current != end && (*current == '+' || *current == '-'))
+            {
+                isExponentNegative = (*current == '-');
+                ++current;
+            }
+            else if (!isDigit(*current))
+            {
+                return false;
+            }
+
+            readCount = 0;
+
+            while (current != end && isDigit(*current))
+            {
+                exponent *= 10;
+                exponent += static_cast<int>(*current - '0');
+                ++current;
+                ++readCount;
+            }
+
+            if (readCount == 0)
+            {
+                return false;
+            }
+
+            exponent *= isExponentNegative ? -1 : 1;
+        }
+
+        *result = (isNegative ? -1 : 1) * (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+        return true;
+    }
+
+    static inline float parseFloat(const char **token)
+    {
+        *token = skipSpaces(*token);
+        const char *end = skipToken(*token, false);
+
+        double value = 0.0;
+        parseDouble(*token, end, &value);
+
+        *token = end;
+        return static_cast<float>(value);
+    }
+
+    // atoi() without crossing into the next line, the file is parsed in place.
+    static inline int parseInt(const char *token)
+    {
+        while (*token == ' ' || *token == '\t' || *token == '\v' || *token == '\f' || *token == '\r')
+        {
+            ++token;
+        }
+
+        bool isNegative = false;
+
+        if (*token == '+' || *token == '-')
+        {
+            isNegative = (*token == '-');
+            ++token;
+        }
+
+        uint32_t value = 0;
+
+        while (isDigit(*token))
+        {
+            value = value * 10 + static_cast<uint32_t>(*token - '0');
+            ++token;
+        }
+
+        return isNegative ? -static_cast<int>(value) : static_cast<int>(value);
+    }
+
+    // OBJ indices are one based, zero is kept as zero and negative values count back from the current element.
+    static inline int32_t fixIndex(int index, uint8_t relativeFlag, uint8_t *flags)
+    {
+        if (index > 0)
+        {
+            return index - 1;
+        }
+
+        if (index < 0)
+        {
+            *flags |= relativeFlag;
+        }
+
+        return index;
+    }
+
+    static bool parseCorner(const char **token, const ObjChunk *chunk, ObjCorner *corner)
+    {
+        corner->positionIndex = fixIndex(parseInt(*token), RELATIVE_POSITION_INDEX, &corner->flags);
+        *token = skipToken(*token, true);
+
+        if (**token != '/')
+        {
+            return false;
+        }
+
+        ++*token;
+
+        // i//k has no texture coordinate.
+        if (**token == '/')
+        {
+            return false;
+        }
+
+        corner->textureCoordinateIndex = fixIndex(parseInt(*token), RELATIVE_TEXTURE_COORDINATE_INDEX, &corner->flags);
+        *token = skipToken(*token, true);
+
+        if (corner->flags & RELATIVE_POSITION_INDEX)
+        {
+            corner->positionIndex += static_cast<int32_t>(chunk->positions.size() / 3);
+        }
+
+        if (corner->flags & RELATIVE_TEXTURE_COORDINATE_INDEX)
+        {
+            corner->textureCoordinateIndex += static_cast<int32_t>(chunk->textureCoordinates.size() / 2);
+        }
+
+        // Normal index is not used by Vertex.
+        if (**token == '/')
+        {
+            ++*token;
+            *token = skipToken(*token, true);
+        }
+
+        return true;
+    }
+
+    static void parseChunk(ObjChunk *chunk)
+    {
+        // Lines end at '\n' (after an optional '\r'), a lone '\r' line ending is left to tinyobj.
+        for (const char *carriageReturn = static_cast<const char *>(memchr(chunk->begin, '\r', chunk->end - chunk->begin));
+             carriageReturn != nullptr;
+             carriageReturn = static_cast<const char *>(memchr(carriageReturn + 1, '\r', chunk->end - carriageReturn - 1)))
+        {
+            if (carriageReturn + 1 == chunk->end || carriageReturn[1] != '\n')
+            {
+                chunk->isSupported = false;
+                return;
+            }
+        }
+
+        std::vector<ObjCorner> face;
+        const char *lineBegin = chunk->begin;
+
+        while (lineBegin < chunk->end)
+        {
+            const char *lineEnd = static_cast<const char *>(memchr(lineBegin, '\n', chunk->end - lineBegin));
+            lineEnd = (lineEnd != nullptr) ? lineEnd : chunk->end;
+
+            const char *token = skipSpaces(lineBegin);
+            lineBegin = lineEnd + 1;
+
+            if (token[0] == 'v' && isSpace(token[1]))
+            {
+                token += 2;
+                chunk->positions.push_back(parseFloat(&token));
+                chunk->positions.push_back(parseFloat(&token));
+                chunk->positions.push_back(parseFloat(&token));
+            }
+            else if (token[0] == 'v' && token[1] == 't' && isSpace(token[2]))
+            {
+                token += 3;
+                chunk->textureCoordinates.push_back(parseFloat(&token));
+                chunk->textureCoordinates.push_back(parseFloat(&token));
+            }
+            else if (token[0] == 'f' && isSpace(token[1]))
+            {
+                token = skipSpaces(token + 2);
+                face.clear();
+
+                while (!isLineEnd(*token))
+                {
+                    ObjCorner corner = {};
+
+                    if (!parseCorner(&token, chunk, &corner))
+                    {
+                        chunk->isSupported = false;
+                        return;
+                    }
+
+                    face.push_back(corner);
+
+                    while (isSpace(*token) || *token == '\r')
+                    {
+                        ++token;
+                    }
+                }
+
+                if (face.size() < 3)
+                {
+                    chunk->isSupported = false;
+                    return;
+                }
+
+                // Triangle fan, same winding as tinyobj's triangulation.
+                for (size_t counter = 2; counter < face.size(); ++counter)
+                {
+                    chunk->corners.push_back(face[0]);
+                    chunk->corners.push_back(face[counter - 1]);
+                    chunk->corners.push_back(face[counter]);
+                }
+            }
+            else if (strncmp(token, "usemtl", 6) == 0 && isSpace(token[6]))
+            {
+                chunk->hasMaterial = true;
+            }
+            else if ((token[0] == 'g' || token[0] == 'o') && isSpace(token[1]))
+            {
+                chunk->hasGroup = true;
+                chunk->hasGroupAfterMaterial = chunk->hasGroupAfterMaterial || chunk->hasMaterial;
+            }
+        }
+    }
+
+    bool parseObjFile(
+        const char *filePath,
+        uint32_t threadCount,
+        float weldTolerance,
+        std::vector<Vertex> *vertices,
+        std::vector<uint32_t> *vertexIndices,
+        ObjParserStatistics *statistics
+    )
+    {
+        std::vector<char> data;
+
+        if (!readFile(filePath, &data))
+        {
+            return false;
+        }
+
+        size_t fileSize = data.size();
+        data.push_back('\0');
+
+        return parseObjData(data.data(), fileSize, threadCount, weldTolerance, vertices, vertexIndices, statistics);
+    }
+
+    bool parseObjData(
+        const char *data,
+        size_t fileSize,
+        uint32_t threadCount,
+        float weldTolerance,
+        std::vector<Vertex> *vertices,
+        std::vector<uint32_t> *vertexIndices,
+        ObjParserStatistics *statistics
+    )
+    {
+        assert(data[fileSize] == '\0' && "OBJ data must be null terminated.");
+
+        const char *fileBegin = data;
+        const char *fileEnd = fileBegin + fileSize;
+
+        if (threadCount == 0)
+        {
+            threadCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+            threadCount = static_cast<uint32_t>(std::min<size_t>(threadCount, std::max<size_t>(fileSize / MIN_CHUNK_SIZE, 1)));
+        }
+
+        // Split on line boundaries, the last chunk takes whatever is left.
+        std::vector<ObjChunk> chunks(threadCount);
+        const char *chunkBegin = fileBegin;
+
+        for (uint32_t counter = 0; counter < threadCount; ++counter)
+        {
+            const char *chunkEnd = fileEnd;
+
+            if (counter + 1 < threadCount && chunkBegin < fileEnd)
+            {
+                const char *splitPoint = std::max(chunkBegin, fileBegin + fileSize * (counter + 1) / threadCount);
+                const char *newLine = static_cast<const char *>(memchr(splitPoint, '\n', fileEnd - splitPoint));
+                chunkEnd = (newLine != nullptr) ? newLine + 1 : fileEnd;
+            }
+
+            chunks[counter].begin = chunkBegin;
+            chunks[counter].end = std::max(chunkBegin, chunkEnd);
+            chunkBegin = chunks[counter].end;
+        }
+
+        std::vector<std::thread> workers;
+
+        for (uint32_t counter = 1; counter < threadCount; ++counter)
+        {
+            workers.emplace_back(parseChunk, &chunks[counter]);
+        }
+
+        parseChunk(&chunks[0]);
+
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        // Merge in file order so the result does not depend on the thread count.
+        size_t positionCount = 0;
+        size_t textureCoordinateCount = 0;
+        size_t cornerCount = 0;
+        bool hasMaterial = false;
+
+        for (const ObjChunk &chunk : chunks)
+        {
+            // tinyobj drops the faces flushed by a material change when a group or object line follows,
+            // leave such files to it so both paths always agree.
+            if (!chunk.isSupported || chunk.hasGroupAfterMaterial || (hasMaterial && chunk.hasGroup))
+            {
+                return false;
+            }
+
+            hasMaterial = hasMaterial || chunk.hasMaterial;
+            positionCount += chunk.positions.size() / 3;
+            textureCoordinateCount += chunk.textureCoordinates.size() / 2;
+            cornerCount += chunk.corners.size();
+        }
+
+        std::vector<float> positions;
+        std::vector<float> textureCoordinates;
+        std::vector<ObjCorner> corners;
+        positions.reserve(positionCount * 3);
+        textureCoordinates.reserve(textureCoordinateCount * 2);
+        corners.reserve(cornerCount);
+
+        for (const ObjChunk &chunk : chunks)
+        {
+            int32_t positionBase = static_cast<int32_t>(positions.size() / 3);
+            int32_t textureCoordinateBase = static_cast<int32_t>(textureCoordinates.size() / 2);
+
+            for (ObjCorner corner : chunk.corners)
+            {
+                corner.positionIndex += (corner.flags & RELATIVE_POSITION_INDEX) ? positionBase : 0;
+                corner.textureCoordinateIndex += (corner.flags & RELATIVE_TEXTURE_COORDINATE_INDEX) ? textureCoordinateBase : 0;
+                corners.push_back(corner);
+            }
+
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            textureCoordinates.insert(textureCoordinates.end(), chunk.textureCoordinates.begin(), chunk.textureCoordinates.end());
+        }
+
+        for (const ObjCorner &corner : corners)
+        {
+            if (corner.positionIndex < 0 || static_cast<size_t>(corner.positionIndex) >= positionCount
+                || corner.textureCoordinateIndex < 0 || static_cast<size_t>(corner.textureCoordinateIndex) >= textureCoordinateCount)
+            {
+                return false;
+            }
+        }
+
+        // De-duplicate exactly like the tinyobj path, first occurrence wins.
+        VertexWelder welder(vertices, corners.size(), weldTolerance);
+        vertexIndices->reserve(vertexIndices->size() + corners.size());
+
+        for (const ObjCorner &corner : corners)
+        {
+            Vertex nextVertex = {};
+            nextVertex.position = {
+                positions[3 * corner.positionIndex + 0],
+                positions[3 * corner.positionIndex + 1],
+                positions[3 * corner.positionIndex + 2]
+            };
+
+            nextVertex.textureCoordinates = {
+                textureCoordinates[2 * corner.textureCoordinateIndex + 0],
+                static_cast<float>(1.0 - textureCoordinates[2 * corner.textureCoordinateIndex + 1])
+            };
+
+            nextVertex.color = { 1.0f, 1.0f, 1.0f };
+
+            vertexIndices->push_back(welder.weld(nextVertex));
+        }
+
+        if (statistics != nullptr)
+        {
+            statistics->chunkCount = threadCount;
+            statistics->fileSize = fileSize;
+            statistics->positionCount = positionCount;
+            statistics->textureCoordinateCount = textureCoordinateCount;
+            statistics->triangleCount = corners.size() / 3;
+        }
+
+        return true;
+    }
+} // namespace xr
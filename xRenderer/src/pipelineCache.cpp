@@ -0,0 +1,78 @@
+#include "pipelineCache.h"
+
+namespace xr
+{
+    // "XRPC" in little endian.
+    static const uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x43505258;
+
+    static PipelineCacheFileHeader makePipelineCacheFileHeader(const VkPhysicalDeviceProperties &properties)
+    {
+        PipelineCacheFileHeader header = {};
+        header.magic = PIPELINE_CACHE_FILE_MAGIC;
+        header.version = PIPELINE_CACHE_FILE_VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+        return header;
+    }
+
+    bool readPipelineCache(const char *cachePath, const VkPhysicalDeviceProperties &properties, std::vector<char> *data)
+    {
+        std::ifstream file(cachePath, std::ios::ate | std::ios::binary);
+
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+
+        if (fileSize < sizeof(PipelineCacheFileHeader))
+        {
+            return false;
+        }
+
+        PipelineCacheFileHeader header = {};
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(&header), sizeof(PipelineCacheFileHeader));
+
+        PipelineCacheFileHeader expectedHeader = makePipelineCacheFileHeader(properties);
+
+        if (header.magic != expectedHeader.magic
+            || header.version != expectedHeader.version
+            || header.vendorID != expectedHeader.vendorID
+            || header.deviceID != expectedHeader.deviceID
+            || header.driverVersion != expectedHeader.driverVersion
+            || memcmp(header.pipelineCacheUUID, expectedHeader.pipelineCacheUUID, VK_UUID_SIZE) != 0
+            || header.dataSize != fileSize - sizeof(PipelineCacheFileHeader))
+        {
+            return false;
+        }
+
+        data->resize(static_cast<size_t>(header.dataSize));
+        file.read(data->data(), data->size());
+
+        if (!file.good() || hashBytes(data->data(), data->size()) != header.dataHash)
+        {
+            data->clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool writePipelineCache(const char *cachePath, const VkPhysicalDeviceProperties &properties, const std::vector<char> &data)
+    {
+        PipelineCacheFileHeader header = makePipelineCacheFileHeader(properties);
+        header.dataSize = data.size();
+        header.dataHash = hashBytes(data.data(), data.size());
+
+        std::vector<char> fileData(sizeof(PipelineCacheFileHeader) + data.size());
+        memcpy(fileData.data(), &header, sizeof(PipelineCacheFileHeader));
+        memcpy(fileData.data() + sizeof(PipelineCacheFileHeader), data.data(), data.size());
+
+        return writeFileAtomically(cachePath, fileData.data(), fileData.size());
+    }
+} // namespace xr
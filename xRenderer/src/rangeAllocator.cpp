@@ -0,0 +1,126 @@
+#include "rangeAllocator.h"
+
+#include <algorithm>
+
+namespace xr
+{
+    void RangeAllocator::reset(VkDeviceSize capacity)
+    {
+        this->capacity = capacity;
+        this->usedSize = 0;
+        this->allocationCount = 0;
+        this->freeRanges.clear();
+
+        if (capacity > 0)
+        {
+            MemoryRange range = {};
+            range.offset = 0;
+            range.size = capacity;
+            this->freeRanges.push_back(range);
+        }
+    }
+
+    void RangeAllocator::grow(VkDeviceSize newCapacity)
+    {
+        if (newCapacity <= this->capacity)
+        {
+            return;
+        }
+
+        if (!this->freeRanges.empty() && this->freeRanges.back().offset + this->freeRanges.back().size == this->capacity)
+        {
+            this->freeRanges.back().size += newCapacity - this->capacity;
+        }
+        else
+        {
+            MemoryRange range = {};
+            range.offset = this->capacity;
+            range.size = newCapacity - this->capacity;
+            this->freeRanges.push_back(range);
+        }
+
+        this->capacity = newCapacity;
+    }
+
+    bool RangeAllocator::allocate(VkDeviceSize requiredSize, VkDeviceSize alignment, RangeAllocation *allocation)
+    {
+        if (alignment == 0)
+        {
+            alignment = 1;
+        }
+
+        // First fit, the padding needed for alignment stays with the allocation and is returned on free.
+        for (size_t index = 0; index < this->freeRanges.size(); ++index)
+        {
+            MemoryRange &range = this->freeRanges[index];
+            VkDeviceSize alignedOffset = alignUp(range.offset, alignment);
+            VkDeviceSize padding = alignedOffset - range.offset;
+
+            if (padding + requiredSize > range.size)
+            {
+                continue;
+            }
+
+            allocation->offset = alignedOffset;
+            allocation->size = requiredSize;
+            allocation->rangeOffset = range.offset;
+            allocation->rangeSize = padding + requiredSize;
+
+            range.offset += allocation->rangeSize;
+            range.size -= allocation->rangeSize;
+
+            if (range.size == 0)
+            {
+                this->freeRanges.erase(this->freeRanges.begin() + index);
+            }
+
+            this->usedSize += allocation->rangeSize;
+            ++this->allocationCount;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void RangeAllocator::free(RangeAllocation *allocation)
+    {
+        if (allocation->rangeSize == 0)
+        {
+            return;
+        }
+
+        MemoryRange freedRange = {};
+        freedRange.offset = allocation->rangeOffset;
+        freedRange.size = allocation->rangeSize;
+
+        auto next = std::lower_bound(
+            this->freeRanges.begin(),
+            this->freeRanges.end(),
+            freedRange,
+            [](const MemoryRange &left, const MemoryRange &right) { return left.offset < right.offset; }
+        );
+
+        size_t index = static_cast<size_t>(next - this->freeRanges.begin());
+        this->freeRanges.insert(next, freedRange);
+
+        // Merge with the following range.
+        if (index + 1 < this->freeRanges.size() && this->freeRanges[index].offset + this->freeRanges[index].size == this->freeRanges[index + 1].offset)
+        {
+            this->freeRanges[index].size += this->freeRanges[index + 1].size;
+            this->freeRanges.erase(this->freeRanges.begin() + index + 1);
+        }
+
+        // Merge with the preceding range.
+        if (index > 0 && this->freeRanges[index - 1].offset + this->freeRanges[index - 1].size == this->freeRanges[index].offset)
+        {
+            this->freeRanges[index - 1].size += this->freeRanges[index].size;
+            this->freeRanges.erase(this->freeRanges.begin() + index);
+        }
+
+        this->usedSize -= allocation->rangeSize;
+        --this->allocationCount;
+
+        *allocation = {};
+    }
+} // namespace xr
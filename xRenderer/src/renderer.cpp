@@ -6,6 +6,23 @@
 
 namespace xr
 {
+    // Below this many draws per worker the hand-off costs more than recording on fewer threads.
+    static const size_t MIN_DRAWS_PER_RECORDING_WORKER = 256;
+
+    // Object capacity the GPU culling buffers start with, they double whenever the scene outgrows them.
+    static const uint32_t GPU_CULLING_MIN_OBJECT_CAPACITY = 1024;
+
+    // Instances the per frame instance buffers start with, they double whenever more models are visible.
+    static const uint32_t MIN_INSTANCE_CAPACITY = 256;
+
+    // Must match local_size_x of cull.comp.
+    static const uint32_t GPU_CULLING_WORKGROUP_SIZE = 64;
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+    // Frames measured in each mode before the benchmark switches between serialized and pipelined rendering.
+    static const uint32_t FRAME_PIPELINING_BENCHMARK_FRAMES = 300;
+#endif
+
     XR_API Renderer::Renderer(VulkanState *vkState)
     {
         this->vkState = vkState;
@@ -114,11 +131,15 @@ namespace xr
             this->vkState->queueFamilyIndices.graphicsFamilyIndex = indices.graphicsFamilyIndex;
             this->vkState->queueFamilyIndices.presentFamilyIndex = indices.presentFamilyIndex;
             this->vkState->queueFamilyIndices.hasSeparatePresentQueue = indices.hasSeparatePresentQueue;
+            this->vkState->queueFamilyIndices.transferFamilyIndex = indices.transferFamilyIndex;
+            this->vkState->queueFamilyIndices.hasSeparateTransferQueue = indices.hasSeparateTransferQueue;
 
             logf("---------- Queue Family Indices ----------");
             logf("Graphics Family Index\t\t: %d", this->vkState->queueFamilyIndices.graphicsFamilyIndex);
             logf("Present Family Index\t\t: %d", this->vkState->queueFamilyIndices.presentFamilyIndex);
             logf("Has Separate Present Queue\t: %d", this->vkState->queueFamilyIndices.hasSeparatePresentQueue);
+            logf("Transfer Family Index\t\t: %d", this->vkState->queueFamilyIndices.transferFamilyIndex);
+            logf("Has Separate Transfer Queue\t: %d", this->vkState->queueFamilyIndices.hasSeparateTransferQueue);
             logf("---------- Queue Family Indices End ----------");
         }
 
@@ -188,9 +209,47 @@ namespace xr
             return false;
         }
 
+        // Prefer a transfer only family (usually backed by a DMA engine), then any non graphics family that
+        // can transfer. The present family is skipped so every family gets at most one queue create info.
+        // Without one, uploads stay on the graphics queue.
+        uint32_t transferFamilyIndex = UINT32_MAX;
+
+        for (uint32_t queueCounter = 0; queueCounter < familyCount; ++queueCounter)
+        {
+            VkQueueFlags queueFlags = familyPropertiesList[queueCounter].queueFlags;
+
+            if (queueCounter != presentFamilyIndex && (queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+            {
+                transferFamilyIndex = queueCounter;
+                break;
+            }
+        }
+
+        if (transferFamilyIndex == UINT32_MAX)
+        {
+            for (uint32_t queueCounter = 0; queueCounter < familyCount; ++queueCounter)
+            {
+                VkQueueFlags queueFlags = familyPropertiesList[queueCounter].queueFlags;
+
+                // Compute queues support transfer implicitly even when the bit is not reported.
+                if (queueCounter != presentFamilyIndex && (queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) && !(queueFlags & VK_QUEUE_GRAPHICS_BIT))
+                {
+                    transferFamilyIndex = queueCounter;
+                    break;
+                }
+            }
+        }
+
+        if (transferFamilyIndex == UINT32_MAX)
+        {
+            transferFamilyIndex = graphicsFamilyIndex;
+        }
+
         queueFamilyIndices->graphicsFamilyIndex = graphicsFamilyIndex;
         queueFamilyIndices->presentFamilyIndex = presentFamilyIndex;
+        queueFamilyIndices->transferFamilyIndex = transferFamilyIndex;
         queueFamilyIndices->hasSeparatePresentQueue = (presentFamilyIndex != graphicsFamilyIndex);
+        queueFamilyIndices->hasSeparateTransferQueue = (transferFamilyIndex != graphicsFamilyIndex);
 
         return true;
     }
@@ -345,11 +404,70 @@ namespace xr
             deviceQueueCreateInfos.push_back(devicePresentQueueCreateInfo);
         }
 
+        // findSuitableDeviceQueues never picks the present family as transfer family.
+        if (this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
+        {
+            VkDeviceQueueCreateInfo deviceTransferQueueCreateInfo = {};
+            deviceTransferQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            deviceTransferQueueCreateInfo.pNext = nullptr;
+            deviceTransferQueueCreateInfo.flags = 0;
+            deviceTransferQueueCreateInfo.queueFamilyIndex = this->vkState->queueFamilyIndices.transferFamilyIndex;
+            deviceTransferQueueCreateInfo.queueCount = 1;
+            deviceTransferQueueCreateInfo.pQueuePriorities = queuePriorities.data();
+
+            deviceQueueCreateInfos.push_back(deviceTransferQueueCreateInfo);
+        }
+
         // As we are using texture sampler, we need to enable this as a device feature.
         // This have many VkBool32 properties, leave it to VK_FALSE right now.
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+        if (this->vkState->isGpuDrivenRenderingAvailable)
+        {
+            VkPhysicalDeviceFeatures supportedFeatures = {};
+            vkGetPhysicalDeviceFeatures(this->vkState->gpuDetails.gpu, &supportedFeatures);
+
+            uint32_t familyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(this->vkState->gpuDetails.gpu, &familyCount, nullptr);
+            std::vector<VkQueueFamilyProperties> familyPropertiesList(familyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(this->vkState->gpuDetails.gpu, &familyCount, familyPropertiesList.data());
+
+            // The culling pass is recorded into the graphics command buffer.
+            bool hasGraphicsCompute = (familyPropertiesList[this->vkState->queueFamilyIndices.graphicsFamilyIndex].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+
+            // One indirect draw covers many objects and firstInstance carries the object index to the vertex shader.
+            if (!supportedFeatures.multiDrawIndirect || !supportedFeatures.drawIndirectFirstInstance || !hasGraphicsCompute)
+            {
+                logf("GPU driven rendering not supported, drawing from the CPU");
+                this->vkState->isGpuDrivenRenderingAvailable = false;
+            }
+            else
+            {
+                deviceFeatures.multiDrawIndirect = VK_TRUE;
+                deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+
+                uint32_t extensionCount = 0;
+                VkResult result = vkEnumerateDeviceExtensionProperties(this->vkState->gpuDetails.gpu, nullptr, &extensionCount, nullptr);
+                CHECK_ERROR(result);
+
+                std::vector<VkExtensionProperties> extensions(extensionCount);
+                result = vkEnumerateDeviceExtensionProperties(this->vkState->gpuDetails.gpu, nullptr, &extensionCount, extensions.data());
+                CHECK_ERROR(result);
+
+                for (const VkExtensionProperties &extension : extensions)
+                {
+                    if (strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+                    {
+                        this->vkState->deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+                        break;
+                    }
+                }
+            }
+        }
+
+        this->vkState->isGpuDrivenRenderingEnabled = this->vkState->isGpuDrivenRenderingEnabled && this->vkState->isGpuDrivenRenderingAvailable;
+
         VkDeviceCreateInfo deviceCreateInfo = {};
         deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         deviceCreateInfo.pNext = nullptr;
@@ -374,10 +492,40 @@ namespace xr
         {
             vkGetDeviceQueue(this->vkState->device, this->vkState->queueFamilyIndices.presentFamilyIndex, 0, &(this->vkState->presentQueue));
         }
+
+        if (!this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
+        {
+            this->vkState->transferQueue = this->vkState->graphicsQueue;
+        }
+        else
+        {
+            vkGetDeviceQueue(this->vkState->device, this->vkState->queueFamilyIndices.transferFamilyIndex, 0, &(this->vkState->transferQueue));
+        }
+
+        if (this->vkState->isGpuDrivenRenderingAvailable)
+        {
+            for (const char *extensionName : this->vkState->deviceExtensions)
+            {
+                if (strcmp(extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+                {
+                    this->vkState->cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                        vkGetDeviceProcAddr(this->vkState->device, "vkCmdDrawIndexedIndirectCountKHR")
+                    );
+                }
+            }
+
+            logf("---------- GPU driven rendering, draw count %s ----------", (this->vkState->cmdDrawIndexedIndirectCount != nullptr) ? "from the GPU" : "fixed");
+        }
+
+        // Every buffer and image memory is sub-allocated from this allocator.
+        this->vkState->memoryAllocator = new MemoryAllocator(this->vkState->device, &(this->vkState->gpuDetails));
     }
 
     XR_API void Renderer::destroyDevice()
     {
+        delete this->vkState->memoryAllocator;
+        this->vkState->memoryAllocator = nullptr;
+
         vkDestroyDevice(this->vkState->device, VK_NULL_HANDLE);
         this->vkState->device = VK_NULL_HANDLE;
     }
@@ -504,6 +652,7 @@ namespace xr
 
         this->vkState->surfaceSize.width = initialSurfaceExtent.width;
         this->vkState->surfaceSize.height = initialSurfaceExtent.height;
+        this->vkState->swapchainExtent = initialSurfaceExtent;
 
         VkPresentModeKHR presentMode = choosePresentMode(this->vkState->swapchainSupportDetails.presentModes);
 
@@ -550,15 +699,18 @@ namespace xr
         swapchainCreateInfo.minImageCount = this->vkState->swapchainImageCount;
         swapchainCreateInfo.imageFormat = this->vkState->surfaceFormat.format;
         swapchainCreateInfo.imageColorSpace = this->vkState->surfaceFormat.colorSpace;
-        swapchainCreateInfo.imageExtent.width = this->vkState->surfaceSize.width;
-        swapchainCreateInfo.imageExtent.height = this->vkState->surfaceSize.height;
+        swapchainCreateInfo.imageExtent.width = this->vkState->swapchainExtent.width;
+        swapchainCreateInfo.imageExtent.height = this->vkState->swapchainExtent.height;
         swapchainCreateInfo.imageArrayLayers = 1;
         swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
         swapchainCreateInfo.preTransform = this->vkState->swapchainSupportDetails.surfaceCapabilities.currentTransform;
         swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         swapchainCreateInfo.presentMode = presentMode;
         swapchainCreateInfo.clipped = VK_TRUE;
-        swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+
+        // On recreation the current swapchain is handed over, the presentation engine can reuse its resources and
+        // images already queued for presentation are still shown.
+        swapchainCreateInfo.oldSwapchain = this->vkState->swapchain;
 
         if (this->vkState->queueFamilyIndices.hasSeparatePresentQueue)
         {
@@ -575,9 +727,17 @@ namespace xr
             swapchainCreateInfo.pQueueFamilyIndices = nullptr; // Ignored if imageSharingMode is VK_SHARING_MODE_EXCLUSIVE
         }
 
+        VkSwapchainKHR oldSwapchain = this->vkState->swapchain;
+
         VkResult result = vkCreateSwapchainKHR(this->vkState->device, &swapchainCreateInfo, nullptr, &(this->vkState->swapchain));
         CHECK_ERROR(result);
 
+        // The old swapchain is retired by the handover, it only has to be destroyed.
+        if (oldSwapchain != VK_NULL_HANDLE)
+        {
+            vkDestroySwapchainKHR(this->vkState->device, oldSwapchain, nullptr);
+        }
+
         result = vkGetSwapchainImagesKHR(this->vkState->device, this->vkState->swapchain, &(this->vkState->swapchainImageCount), nullptr);
         CHECK_ERROR(result);
 
@@ -639,25 +799,53 @@ namespace xr
 
     XR_API void Renderer::initGraphicsPiplineCache()
     {
+        // A cache written by another device, driver or build of the cache is ignored and the pipelines compile cold.
+        std::vector<char> cacheData;
+
+        this->vkState->isPipelineCacheWarm = this->vkState->pipelineCacheFilePath != NULL
+                                          && readPipelineCache(this->vkState->pipelineCacheFilePath, this->vkState->gpuDetails.properties, &cacheData);
+
         VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
         pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
         pipelineCacheCreateInfo.pNext = NULL;
         pipelineCacheCreateInfo.flags = 0;
-        pipelineCacheCreateInfo.initialDataSize = 0;
-        pipelineCacheCreateInfo.pInitialData = NULL;
+        pipelineCacheCreateInfo.initialDataSize = cacheData.size();
+        pipelineCacheCreateInfo.pInitialData = cacheData.empty() ? NULL : cacheData.data();
 
         VkResult result = vkCreatePipelineCache(this->vkState->device, &pipelineCacheCreateInfo, nullptr, &(this->vkState->pipelineCache));
         CHECK_ERROR(result);
+
+        logf("---------- Pipeline cache: %s, %zu bytes loaded ----------", this->vkState->isPipelineCacheWarm ? "warm" : "cold", cacheData.size());
     }
 
     XR_API void Renderer::destroyGraphicsPiplineCache()
     {
+        // Everything compiled during this run is written back for the next start.
+        if (this->vkState->pipelineCacheFilePath != NULL)
+        {
+            size_t cacheDataSize = 0;
+            VkResult result = vkGetPipelineCacheData(this->vkState->device, this->vkState->pipelineCache, &cacheDataSize, nullptr);
+            CHECK_ERROR(result);
+
+            std::vector<char> cacheData(cacheDataSize);
+            result = vkGetPipelineCacheData(this->vkState->device, this->vkState->pipelineCache, &cacheDataSize, cacheData.data());
+            CHECK_ERROR(result);
+            cacheData.resize(cacheDataSize);
+
+            if (!writePipelineCache(this->vkState->pipelineCacheFilePath, this->vkState->gpuDetails.properties, cacheData))
+            {
+                logf("Cannot write pipeline cache file: %s", this->vkState->pipelineCacheFilePath);
+            }
+        }
+
         vkDestroyPipelineCache(this->vkState->device, this->vkState->pipelineCache, nullptr);
         this->vkState->pipelineCache = VK_NULL_HANDLE;
     }
 
     XR_API void Renderer::initGraphicsPipline()
     {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
         std::vector<char> vertexShaderCode;
         std::vector<char> fragmentShaderCode;
 
@@ -696,17 +884,24 @@ namespace xr
 
         VkPipelineShaderStageCreateInfo shaderStageCreateInfos[] = { vertexShaderStageCreateInfo, fragmentShaderStageCreateInfo };
 
-        VkVertexInputBindingDescription vertexBindingDescription = Vertex::getBindingDescription();
-        std::array<VkVertexInputAttributeDescription, 3> vertexAttributeDescription = Vertex::getAttributeDescription();
+        // Binding 0 is the shared vertex geometry, binding 1 the per instance transforms.
+        std::array<VkVertexInputBindingDescription, 2> vertexBindingDescriptions = {
+            CompactVertexLayout::getBindingDescription(0), InstanceLayout::getBindingDescription(1, VK_VERTEX_INPUT_RATE_INSTANCE)
+        };
+        std::array<VkVertexInputAttributeDescription, CompactVertexLayout::attributeCount> vertexAttributeDescription = CompactVertexLayout::getAttributeDescription(0);
+        std::array<VkVertexInputAttributeDescription, InstanceLayout::attributeCount> instanceAttributeDescription = InstanceLayout::getAttributeDescription(1);
+
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(vertexAttributeDescription.begin(), vertexAttributeDescription.end());
+        attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributeDescription.begin(), instanceAttributeDescription.end());
 
         VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {};
         vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vertexInputStateCreateInfo.pNext = nullptr;
         vertexInputStateCreateInfo.flags = 0;
-        vertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-        vertexInputStateCreateInfo.pVertexBindingDescriptions = &vertexBindingDescription;
-        vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributeDescription.size());
-        vertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexAttributeDescription.data();
+        vertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexBindingDescriptions.size());
+        vertexInputStateCreateInfo.pVertexBindingDescriptions = vertexBindingDescriptions.data();
+        vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputStateCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo = {};
         inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -715,27 +910,15 @@ namespace xr
         inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         inputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
 
-        VkViewport viewport = {};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = (float)this->vkState->surfaceSize.width;
-        viewport.height = (float)this->vkState->surfaceSize.height;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-
-        VkRect2D scissor = {};
-        scissor.offset = { 0, 0 };
-        scissor.extent.width = this->vkState->surfaceSize.width;
-        scissor.extent.height = this->vkState->surfaceSize.height;
-
+        // Viewport and scissor are dynamic, see setViewportAndScissor(), so the pipelines do not depend on the window size.
         VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
         viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportStateCreateInfo.pNext = nullptr;
         viewportStateCreateInfo.flags = 0;
         viewportStateCreateInfo.viewportCount = 1;
-        viewportStateCreateInfo.pViewports = &viewport;
+        viewportStateCreateInfo.pViewports = nullptr;
         viewportStateCreateInfo.scissorCount = 1;
-        viewportStateCreateInfo.pScissors = &scissor;
+        viewportStateCreateInfo.pScissors = nullptr;
 
         VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo = {};
         rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -800,9 +983,7 @@ namespace xr
         colorBlendingStateCreateInfo.blendConstants[2] = 0.0f;
         colorBlendingStateCreateInfo.blendConstants[3] = 0.0f;
 
-        // We are not yet using the dynamic state hence removing this for now.
-        // std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_LINE_WIDTH };
-        std::vector<VkDynamicState> dynamicStates = {};
+        std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
 
         VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
         dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
@@ -811,14 +992,22 @@ namespace xr
         dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
         dynamicStateCreateInfo.pDynamicStates = dynamicStates.data();
 
+        std::array<VkDescriptorSetLayout, 2> setLayouts = { this->vkState->descriptorSetLayout, this->vkState->textureDescriptorSetLayout };
+
+        // The texture transform is pushed per draw, the camera comes from the uniform buffer in set 0.
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(xr::ObjectPushConstants);
+
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
         pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutCreateInfo.pNext = nullptr;
         pipelineLayoutCreateInfo.flags = 0;
-        pipelineLayoutCreateInfo.setLayoutCount = 1;
-        pipelineLayoutCreateInfo.pSetLayouts = &(this->vkState->descriptorSetLayout);
-        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-        pipelineLayoutCreateInfo.pPushConstantRanges = 0;
+        pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
         VkResult result = vkCreatePipelineLayout(this->vkState->device, &pipelineLayoutCreateInfo, nullptr, &(this->vkState->pipelineLayout));
         CHECK_ERROR(result);
@@ -847,14 +1036,81 @@ namespace xr
         result = vkCreateGraphicsPipelines(this->vkState->device, this->vkState->pipelineCache, 1, &pipelineCreateInfo, nullptr, &(this->vkState->pipeline));
         CHECK_ERROR(result);
 
+        if (this->vkState->isGpuDrivenRenderingAvailable)
+        {
+            std::vector<char> indirectVertexShaderCode;
+
+            if (!readFile(this->vkState->indirectVertexShaderFilePath, &indirectVertexShaderCode))
+            {
+                logf("Cannot open indirect vertex shader file: %s", this->vkState->indirectVertexShaderFilePath);
+                assert(0 && "Cannot open indirect vertex shader.");
+            }
+
+            // Same state, only the vertex shader differs, it reads the object from set 2 with gl_InstanceIndex instead of
+            // the instance stream and push constants.
+            VkShaderModule indirectVertexShaderModule = this->createShaderModule(indirectVertexShaderCode);
+            shaderStageCreateInfos[0].module = indirectVertexShaderModule;
+
+            vertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
+            vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributeDescription.size());
+
+            std::array<VkDescriptorSetLayout, 3> indirectSetLayouts = {
+                this->vkState->descriptorSetLayout, this->vkState->textureDescriptorSetLayout, this->vkState->gpuCullingDescriptorSetLayout
+            };
+
+            pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(indirectSetLayouts.size());
+            pipelineLayoutCreateInfo.pSetLayouts = indirectSetLayouts.data();
+            pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+            pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+
+            result = vkCreatePipelineLayout(this->vkState->device, &pipelineLayoutCreateInfo, nullptr, &(this->vkState->indirectPipelineLayout));
+            CHECK_ERROR(result);
+
+            pipelineCreateInfo.layout = this->vkState->indirectPipelineLayout;
+
+            result = vkCreateGraphicsPipelines(this->vkState->device, this->vkState->pipelineCache, 1, &pipelineCreateInfo, nullptr, &(this->vkState->indirectPipeline));
+            CHECK_ERROR(result);
+
+            vkDestroyShaderModule(this->vkState->device, indirectVertexShaderModule, nullptr);
+        }
+
         vkDestroyShaderModule(this->vkState->device, fragmentShaderModule, nullptr);
         vkDestroyShaderModule(this->vkState->device, vertexShaderModule, nullptr);
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        logf(
+            "---------- Graphics pipelines created in %f ms, %s pipeline cache ----------",
+            std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count(),
+            this->vkState->isPipelineCacheWarm ? "warm" : "cold"
+        );
+    }
+
+    void Renderer::setViewportAndScissor(VkCommandBuffer commandBuffer)
+    {
+        VkViewport viewport = {};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = (float)this->vkState->swapchainExtent.width;
+        viewport.height = (float)this->vkState->swapchainExtent.height;
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+
+        VkRect2D scissor = {};
+        scissor.offset = { 0, 0 };
+        scissor.extent = this->vkState->swapchainExtent;
+
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
     }
 
     XR_API void Renderer::destroyGraphicsPipline()
     {
+        vkDestroyPipeline(this->vkState->device, this->vkState->indirectPipeline, nullptr);
+        vkDestroyPipelineLayout(this->vkState->device, this->vkState->indirectPipelineLayout, nullptr);
         vkDestroyPipeline(this->vkState->device, this->vkState->pipeline, nullptr);
         vkDestroyPipelineLayout(this->vkState->device, this->vkState->pipelineLayout, nullptr);
+        this->vkState->indirectPipeline = VK_NULL_HANDLE;
+        this->vkState->indirectPipelineLayout = VK_NULL_HANDLE;
         this->vkState->pipeline = VK_NULL_HANDLE;
         this->vkState->pipelineLayout = VK_NULL_HANDLE;
     }
@@ -906,8 +1162,8 @@ namespace xr
         }
 
         createImage(
-            this->vkState->surfaceSize.width,
-            this->vkState->surfaceSize.height,
+            this->vkState->swapchainExtent.width,
+            this->vkState->swapchainExtent.height,
             1,
             this->vkState->msaaSamples,
             depthStencilFormat,
@@ -915,7 +1171,8 @@ namespace xr
             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             this->vkState->depthImage,
-            this->vkState->depthImageMemory
+            this->vkState->depthImageAllocation,
+            true
         );
 
         createImageView(this->vkState->depthImage, depthStencilFormat, this->vkState->depthImageView, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
@@ -924,18 +1181,15 @@ namespace xr
     XR_API void Renderer::destroyDepthStencilImage()
     {
         vkDestroyImageView(this->vkState->device, this->vkState->depthImageView, nullptr);
-        vkDestroyImage(this->vkState->device, this->vkState->depthImage, nullptr);
-        vkFreeMemory(this->vkState->device, this->vkState->depthImageMemory, nullptr);
+        destroyImage(this->vkState->depthImage, this->vkState->depthImageAllocation);
         this->vkState->depthImageView = VK_NULL_HANDLE;
-        this->vkState->depthImage = VK_NULL_HANDLE;
-        this->vkState->depthImageMemory = VK_NULL_HANDLE;
     }
 
     XR_API void Renderer::initMSAAColorImage()
     {
         createImage(
-            this->vkState->surfaceSize.width,
-            this->vkState->surfaceSize.height,
+            this->vkState->swapchainExtent.width,
+            this->vkState->swapchainExtent.height,
             1,
             this->vkState->msaaSamples,
             this->vkState->surfaceFormat.format,
@@ -943,7 +1197,8 @@ namespace xr
             VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             this->vkState->msaaColorImage,
-            this->vkState->msaaColorImageMemory
+            this->vkState->msaaColorImageAllocation,
+            true
         );
 
         createImageView(this->vkState->msaaColorImage, this->vkState->surfaceFormat.format, this->vkState->msaaColorImageView, VK_IMAGE_ASPECT_COLOR_BIT, 1);
@@ -952,11 +1207,8 @@ namespace xr
     XR_API void Renderer::destroyMSAAColorImage()
     {
         vkDestroyImageView(this->vkState->device, this->vkState->msaaColorImageView, nullptr);
-        vkDestroyImage(this->vkState->device, this->vkState->msaaColorImage, nullptr);
-        vkFreeMemory(this->vkState->device, this->vkState->msaaColorImageMemory, nullptr);
+        destroyImage(this->vkState->msaaColorImage, this->vkState->msaaColorImageAllocation);
         this->vkState->msaaColorImageView = VK_NULL_HANDLE;
-        this->vkState->msaaColorImage = VK_NULL_HANDLE;
-        this->vkState->msaaColorImageMemory = VK_NULL_HANDLE;
     }
 
     XR_API void Renderer::initRenderPass()
@@ -1055,34 +1307,75 @@ namespace xr
     {
         VkDescriptorSetLayoutBinding uboDescriptorSetLayoutBinding = {};
         uboDescriptorSetLayoutBinding.binding = 0;
-        uboDescriptorSetLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uboDescriptorSetLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         uboDescriptorSetLayoutBinding.descriptorCount = 1;
-        uboDescriptorSetLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        uboDescriptorSetLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
         uboDescriptorSetLayoutBinding.pImmutableSamplers = nullptr;
 
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+        descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCreateInfo.pNext = nullptr;
+        descriptorSetLayoutCreateInfo.flags = 0;
+        descriptorSetLayoutCreateInfo.bindingCount = 1;
+        descriptorSetLayoutCreateInfo.pBindings = &uboDescriptorSetLayoutBinding;
+
+        VkResult result = vkCreateDescriptorSetLayout(this->vkState->device, &descriptorSetLayoutCreateInfo, nullptr, &this->vkState->descriptorSetLayout);
+        CHECK_ERROR(result);
+
         VkDescriptorSetLayoutBinding samplerDescriptorSetLayoutBinding = {};
-        samplerDescriptorSetLayoutBinding.binding = 1;
+        samplerDescriptorSetLayoutBinding.binding = 0;
         samplerDescriptorSetLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         samplerDescriptorSetLayoutBinding.descriptorCount = 1;
         samplerDescriptorSetLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         samplerDescriptorSetLayoutBinding.pImmutableSamplers = nullptr;
 
-        std::array<VkDescriptorSetLayoutBinding, 2> layoutBindings = { uboDescriptorSetLayoutBinding, samplerDescriptorSetLayoutBinding };
+        VkDescriptorSetLayoutCreateInfo textureDescriptorSetLayoutCreateInfo = {};
+        textureDescriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        textureDescriptorSetLayoutCreateInfo.pNext = nullptr;
+        textureDescriptorSetLayoutCreateInfo.flags = 0;
+        textureDescriptorSetLayoutCreateInfo.bindingCount = 1;
+        textureDescriptorSetLayoutCreateInfo.pBindings = &samplerDescriptorSetLayoutBinding;
 
-        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
-        descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        descriptorSetLayoutCreateInfo.pNext = nullptr;
-        descriptorSetLayoutCreateInfo.flags = 0;
-        descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-        descriptorSetLayoutCreateInfo.pBindings = layoutBindings.data();
+        result = vkCreateDescriptorSetLayout(this->vkState->device, &textureDescriptorSetLayoutCreateInfo, nullptr, &this->vkState->textureDescriptorSetLayout);
+        CHECK_ERROR(result);
 
-        VkResult result = vkCreateDescriptorSetLayout(this->vkState->device, &descriptorSetLayoutCreateInfo, nullptr, &this->vkState->descriptorSetLayout);
+        if (!this->vkState->isGpuDrivenRenderingAvailable)
+        {
+            return;
+        }
+
+        // Objects, draw commands and draw counts of the culling pass, the indirect vertex shader only reads the objects.
+        std::array<VkDescriptorSetLayoutBinding, 3> cullingDescriptorSetLayoutBindings = {};
+
+        for (uint32_t binding = 0; binding < cullingDescriptorSetLayoutBindings.size(); ++binding)
+        {
+            cullingDescriptorSetLayoutBindings[binding].binding = binding;
+            cullingDescriptorSetLayoutBindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            cullingDescriptorSetLayoutBindings[binding].descriptorCount = 1;
+            cullingDescriptorSetLayoutBindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            cullingDescriptorSetLayoutBindings[binding].pImmutableSamplers = nullptr;
+        }
+
+        cullingDescriptorSetLayoutBindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+        VkDescriptorSetLayoutCreateInfo cullingDescriptorSetLayoutCreateInfo = {};
+        cullingDescriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        cullingDescriptorSetLayoutCreateInfo.pNext = nullptr;
+        cullingDescriptorSetLayoutCreateInfo.flags = 0;
+        cullingDescriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(cullingDescriptorSetLayoutBindings.size());
+        cullingDescriptorSetLayoutCreateInfo.pBindings = cullingDescriptorSetLayoutBindings.data();
+
+        result = vkCreateDescriptorSetLayout(this->vkState->device, &cullingDescriptorSetLayoutCreateInfo, nullptr, &this->vkState->gpuCullingDescriptorSetLayout);
         CHECK_ERROR(result);
     }
 
     XR_API void Renderer::destroyDescriptorSetLayout()
     {
+        vkDestroyDescriptorSetLayout(this->vkState->device, this->vkState->gpuCullingDescriptorSetLayout, nullptr);
+        this->vkState->gpuCullingDescriptorSetLayout = VK_NULL_HANDLE;
+        vkDestroyDescriptorSetLayout(this->vkState->device, this->vkState->textureDescriptorSetLayout, nullptr);
         vkDestroyDescriptorSetLayout(this->vkState->device, this->vkState->descriptorSetLayout, nullptr);
+        this->vkState->textureDescriptorSetLayout = VK_NULL_HANDLE;
         this->vkState->descriptorSetLayout = VK_NULL_HANDLE;
     }
 
@@ -1103,8 +1396,8 @@ namespace xr
             framebufferCreateInfo.renderPass = this->vkState->renderPass;
             framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
             framebufferCreateInfo.pAttachments = attachments.data();
-            framebufferCreateInfo.width = this->vkState->surfaceSize.width;
-            framebufferCreateInfo.height = this->vkState->surfaceSize.height;
+            framebufferCreateInfo.width = this->vkState->swapchainExtent.width;
+            framebufferCreateInfo.height = this->vkState->swapchainExtent.height;
             framebufferCreateInfo.layers = 1;
 
             VkResult result =
@@ -1133,10 +1426,166 @@ namespace xr
 
         VkResult result = vkCreateCommandPool(this->vkState->device, &commandPoolCreateInfo, nullptr, &(this->vkState->commandPool));
         CHECK_ERROR(result);
+
+        if (!this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
+        {
+            this->vkState->transferCommandPool = this->vkState->commandPool;
+            return;
+        }
+
+        commandPoolCreateInfo.queueFamilyIndex = this->vkState->queueFamilyIndices.transferFamilyIndex;
+
+        result = vkCreateCommandPool(this->vkState->device, &commandPoolCreateInfo, nullptr, &(this->vkState->transferCommandPool));
+        CHECK_ERROR(result);
+    }
+
+    XR_API void Renderer::initRecordingWorkers()
+    {
+        uint32_t workerCount = this->vkState->recordingWorkerCount;
+
+        if (workerCount == 0)
+        {
+            workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        this->vkState->recordingWorkerPool = new WorkerPool(workerCount);
+        logf("---------- Command recording with %d workers ----------", this->vkState->recordingWorkerPool->getWorkerCount());
+    }
+
+    XR_API void Renderer::destroyRecordingWorkers()
+    {
+        delete this->vkState->recordingWorkerPool;
+        this->vkState->recordingWorkerPool = nullptr;
+    }
+
+    XR_API void Renderer::initGpuCulling()
+    {
+        if (!this->vkState->isGpuDrivenRenderingAvailable)
+        {
+            return;
+        }
+
+        std::vector<char> computeShaderCode;
+
+        if (!readFile(this->vkState->cullComputeShaderFilePath, &computeShaderCode))
+        {
+            logf("Cannot open cull compute shader file: %s", this->vkState->cullComputeShaderFilePath);
+            assert(0 && "Cannot open cull compute shader.");
+        }
+
+        VkShaderModule computeShaderModule = this->createShaderModule(computeShaderCode);
+
+        // Set 0 is the camera block shared with the graphics pipelines, set 1 the frame's culling buffers.
+        std::array<VkDescriptorSetLayout, 2> setLayouts = { this->vkState->descriptorSetLayout, this->vkState->gpuCullingDescriptorSetLayout };
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(xr::GpuCullingPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.pNext = nullptr;
+        pipelineLayoutCreateInfo.flags = 0;
+        pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+        VkResult result = vkCreatePipelineLayout(this->vkState->device, &pipelineLayoutCreateInfo, nullptr, &(this->vkState->cullPipelineLayout));
+        CHECK_ERROR(result);
+
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.pNext = nullptr;
+        pipelineCreateInfo.flags = 0;
+        pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCreateInfo.stage.pNext = nullptr;
+        pipelineCreateInfo.stage.flags = 0;
+        pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreateInfo.stage.module = computeShaderModule;
+        pipelineCreateInfo.stage.pName = "main";
+        pipelineCreateInfo.stage.pSpecializationInfo = nullptr;
+        pipelineCreateInfo.layout = this->vkState->cullPipelineLayout;
+        pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineCreateInfo.basePipelineIndex = -1;
+
+        result = vkCreateComputePipelines(this->vkState->device, this->vkState->pipelineCache, 1, &pipelineCreateInfo, nullptr, &(this->vkState->cullPipeline));
+        CHECK_ERROR(result);
+
+        vkDestroyShaderModule(this->vkState->device, computeShaderModule, nullptr);
+
+        // One set per frame in flight, rewritten in place whenever the buffers grow.
+        VkDescriptorPoolSize storagePoolSize = {};
+        storagePoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        storagePoolSize.descriptorCount = 3 * this->vkState->MAX_FRAMES_IN_FLIGHT;
+
+        VkDescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.pNext = nullptr;
+        poolCreateInfo.flags = 0;
+        poolCreateInfo.maxSets = this->vkState->MAX_FRAMES_IN_FLIGHT;
+        poolCreateInfo.poolSizeCount = 1;
+        poolCreateInfo.pPoolSizes = &storagePoolSize;
+
+        result = vkCreateDescriptorPool(this->vkState->device, &poolCreateInfo, nullptr, &(this->vkState->gpuCullingDescriptorPool));
+        CHECK_ERROR(result);
+
+        this->vkState->gpuCullingFrames.assign(this->vkState->MAX_FRAMES_IN_FLIGHT, GpuCullingFrame());
+
+        for (GpuCullingFrame &cullingFrame : this->vkState->gpuCullingFrames)
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+            descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.pNext = nullptr;
+            descriptorSetAllocateInfo.descriptorPool = this->vkState->gpuCullingDescriptorPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts = &(this->vkState->gpuCullingDescriptorSetLayout);
+
+            result = vkAllocateDescriptorSets(this->vkState->device, &descriptorSetAllocateInfo, &(cullingFrame.descriptorSet));
+            CHECK_ERROR(result);
+        }
+
+        for (size_t frameIndex = 0; frameIndex < this->vkState->gpuCullingFrames.size(); ++frameIndex)
+        {
+            growGpuCullingBuffers(frameIndex, GPU_CULLING_MIN_OBJECT_CAPACITY);
+        }
+    }
+
+    XR_API void Renderer::destroyGpuCulling()
+    {
+        if (!this->vkState->isGpuDrivenRenderingAvailable)
+        {
+            return;
+        }
+
+        destroyGpuCullingBuffers();
+
+        // The sets are released with the pool.
+        vkDestroyDescriptorPool(this->vkState->device, this->vkState->gpuCullingDescriptorPool, nullptr);
+        vkDestroyPipeline(this->vkState->device, this->vkState->cullPipeline, nullptr);
+        vkDestroyPipelineLayout(this->vkState->device, this->vkState->cullPipelineLayout, nullptr);
+
+        this->vkState->gpuCullingDescriptorPool = VK_NULL_HANDLE;
+        this->vkState->cullPipeline = VK_NULL_HANDLE;
+        this->vkState->cullPipelineLayout = VK_NULL_HANDLE;
+        this->vkState->gpuCullingFrames.clear();
+        this->vkState->gpuSourceModels.clear();
+        this->vkState->gpuSourceTextureSets.clear();
+        this->vkState->gpuObjectOrder.clear();
+        this->vkState->gpuObjectGroups.clear();
+        this->vkState->indirectDrawGroups.clear();
     }
 
     XR_API void Renderer::destroyCommandPool()
     {
+        if (this->vkState->transferCommandPool != this->vkState->commandPool)
+        {
+            vkDestroyCommandPool(this->vkState->device, this->vkState->transferCommandPool, nullptr);
+        }
+
+        this->vkState->transferCommandPool = VK_NULL_HANDLE;
+
         vkDestroyCommandPool(this->vkState->device, this->vkState->commandPool, nullptr);
         this->vkState->commandPool = VK_NULL_HANDLE;
     }
@@ -1151,7 +1600,8 @@ namespace xr
         VkImageUsageFlags usage,
         VkMemoryPropertyFlags memoryPropertyFlags,
         VkImage &image,
-        VkDeviceMemory &imageMemory
+        MemoryAllocation &imageAllocation,
+        bool isDedicated
     )
     {
         VkImageCreateInfo imageCreateInfo = {};
@@ -1179,18 +1629,19 @@ namespace xr
         VkMemoryRequirements imageMemoryRequirements = {};
         vkGetImageMemoryRequirements(this->vkState->device, image, &imageMemoryRequirements);
 
-        uint32_t memoryIndex = findMemoryTypeIndex(&(this->vkState->gpuDetails.memoryProperties), &imageMemoryRequirements, memoryPropertyFlags);
-
-        VkMemoryAllocateInfo memoryAllocationInfo = {};
-        memoryAllocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memoryAllocationInfo.pNext = nullptr;
-        memoryAllocationInfo.allocationSize = imageMemoryRequirements.size;
-        memoryAllocationInfo.memoryTypeIndex = memoryIndex;
+        bool isLinearResource = tiling == VK_IMAGE_TILING_LINEAR;
+        result = this->vkState->memoryAllocator->allocate(&imageMemoryRequirements, memoryPropertyFlags, isLinearResource, isDedicated, &imageAllocation);
+        CHECK_ERROR(result);
 
-        result = vkAllocateMemory(this->vkState->device, &memoryAllocationInfo, nullptr, &imageMemory);
+        result = vkBindImageMemory(this->vkState->device, image, imageAllocation.memory, imageAllocation.offset);
         CHECK_ERROR(result);
+    }
 
-        vkBindImageMemory(this->vkState->device, image, imageMemory, 0);
+    XR_API void Renderer::destroyImage(VkImage &image, MemoryAllocation &imageAllocation)
+    {
+        vkDestroyImage(this->vkState->device, image, nullptr);
+        this->vkState->memoryAllocator->free(&imageAllocation);
+        image = VK_NULL_HANDLE;
     }
 
     XR_API void Renderer::createImageView(VkImage image, VkFormat format, VkImageView &imageView, VkImageAspectFlags imageAspectFlags, uint32_t mipLevels)
@@ -1229,31 +1680,19 @@ namespace xr
             assert(0 && "Not able to load texture");
         }
 
-        VkDeviceSize size = textureWidth * textureHeight * 4;
+        initTextureImage(model, pixels, static_cast<uint32_t>(textureWidth), static_cast<uint32_t>(textureHeight));
+        stbi_image_free(pixels);
+    }
+
+    XR_API void Renderer::initTextureImage(Model *model, const unsigned char *pixels, uint32_t textureWidth, uint32_t textureHeight)
+    {
         model->mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(textureWidth, textureHeight)))) + 1;
 
         logf("---------- mipLevels: %d----------", model->mipLevels);
 
-        VkBuffer stagingImageBuffer = VK_NULL_HANDLE;
-        VkDeviceMemory stagingImageBufferMemory = VK_NULL_HANDLE;
-
-        createBuffer(
-            size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            &stagingImageBuffer,
-            &stagingImageBufferMemory
-        );
-
-        void *data = nullptr;
-        vkMapMemory(this->vkState->device, stagingImageBufferMemory, 0, size, 0, &data);
-        memcpy(data, pixels, size);
-        vkUnmapMemory(this->vkState->device, stagingImageBufferMemory);
-        stbi_image_free(pixels);
-
         createImage(
-            static_cast<uint32_t>(textureWidth),
-            static_cast<uint32_t>(textureHeight),
+            textureWidth,
+            textureHeight,
             model->mipLevels,
             VK_SAMPLE_COUNT_1_BIT,
             VK_FORMAT_R8G8B8A8_UNORM,
@@ -1261,26 +1700,23 @@ namespace xr
             VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             model->textureImage,
-            model->textureImageMemory
+            model->textureImageAllocation
         );
 
         transitionImageLayout(model->textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, model->mipLevels);
 
-        copyBufferToImage(stagingImageBuffer, model->textureImage, static_cast<uint32_t>(textureWidth), static_cast<uint32_t>(textureHeight));
+        uploadToImage(model->textureImage, pixels, textureWidth, textureHeight, 4);
 
-        // Generate the mipmaps images and then transition image layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
-        generateMipmaps(model->textureImage, textureWidth, textureHeight, model->mipLevels);
+        // Mipmaps are generated with blits, which the transfer queue cannot do.
+        transferImageOwnership(model->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, model->mipLevels);
 
-        vkDestroyBuffer(this->vkState->device, stagingImageBuffer, nullptr);
-        vkFreeMemory(this->vkState->device, stagingImageBufferMemory, nullptr);
+        // Generate the mipmaps images and then transition image layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+        generateMipmaps(model->textureImage, static_cast<int32_t>(textureWidth), static_cast<int32_t>(textureHeight), model->mipLevels);
     }
 
     XR_API void Renderer::destroyTextureImage(Model *model)
     {
-        vkDestroyImage(this->vkState->device, model->textureImage, nullptr);
-        vkFreeMemory(this->vkState->device, model->textureImageMemory, nullptr);
-        model->textureImage = VK_NULL_HANDLE;
-        model->textureImageMemory = VK_NULL_HANDLE;
+        destroyImage(model->textureImage, model->textureImageAllocation);
     }
 
     void Renderer::generateMipmaps(VkImage &image, int32_t textureWidth, int32_t textureHeight, uint32_t mipLevels)
@@ -1288,8 +1724,9 @@ namespace xr
         int32_t mipWidth = textureWidth;
         int32_t mipHeight = textureHeight;
 
+        // Blits and the final transition to the fragment shader need a graphics queue.
         VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
-        beginOneTimeCommand(commandBuffer);
+        beginOneTimeCommand(commandBuffer, true);
 
         VkImageMemoryBarrier imageMemoryBarrier = {};
         imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -1445,7 +1882,7 @@ namespace xr
         VkBufferUsageFlags bufferUsage,
         VkMemoryPropertyFlags memoryProperties,
         VkBuffer *buffer,
-        VkDeviceMemory *bufferMemory
+        MemoryAllocation *bufferAllocation
     )
     {
         VkBufferCreateInfo bufferCreateInfo = {};
@@ -1464,23 +1901,32 @@ namespace xr
         VkMemoryRequirements bufferMemoryRequirements = {};
         vkGetBufferMemoryRequirements(this->vkState->device, *buffer, &bufferMemoryRequirements);
 
-        uint32_t memoryIndex = findMemoryTypeIndex(&(this->vkState->gpuDetails.memoryProperties), &bufferMemoryRequirements, memoryProperties);
-
-        VkMemoryAllocateInfo memoryAllocationInfo = {};
-        memoryAllocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memoryAllocationInfo.pNext = nullptr;
-        memoryAllocationInfo.allocationSize = bufferMemoryRequirements.size;
-        memoryAllocationInfo.memoryTypeIndex = memoryIndex;
-
-        result = vkAllocateMemory(this->vkState->device, &memoryAllocationInfo, nullptr, bufferMemory);
+        result = this->vkState->memoryAllocator->allocate(&bufferMemoryRequirements, memoryProperties, true, false, bufferAllocation);
         CHECK_ERROR(result);
 
-        result = vkBindBufferMemory(this->vkState->device, *buffer, *bufferMemory, 0);
+        result = vkBindBufferMemory(this->vkState->device, *buffer, bufferAllocation->memory, bufferAllocation->offset);
         CHECK_ERROR(result);
     }
 
-    void Renderer::beginOneTimeCommand(VkCommandBuffer &commandBuffer)
+    XR_API void Renderer::destroyBuffer(VkBuffer *buffer, MemoryAllocation *bufferAllocation)
     {
+        vkDestroyBuffer(this->vkState->device, *buffer, nullptr);
+        this->vkState->memoryAllocator->free(bufferAllocation);
+        *buffer = VK_NULL_HANDLE;
+    }
+
+    void Renderer::beginOneTimeCommand(VkCommandBuffer &commandBuffer, bool needsGraphicsQueue)
+    {
+        // Inside an upload batch every command is recorded into the shared batch command buffers.
+        if (this->vkState->isUploadBatchOpen)
+        {
+            commandBuffer = needsGraphicsQueue ? this->vkState->uploadGraphicsCommandBuffer : this->vkState->uploadCommandBuffer;
+            return;
+        }
+
+        // A submitted batch may still be reading from the staging buffer.
+        waitForUploadBatch();
+
         VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
         commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         commandBufferAllocateInfo.pNext = nullptr;
@@ -1502,6 +1948,12 @@ namespace xr
 
     void Renderer::endOneTimeCommand(VkCommandBuffer &commandBuffer)
     {
+        if (this->vkState->isUploadBatchOpen &&
+            (commandBuffer == this->vkState->uploadCommandBuffer || commandBuffer == this->vkState->uploadGraphicsCommandBuffer))
+        {
+            return;
+        }
+
         VkResult result = vkEndCommandBuffer(commandBuffer);
         CHECK_ERROR(result);
 
@@ -1521,6 +1973,9 @@ namespace xr
 
         vkQueueWaitIdle(this->vkState->graphicsQueue);
         vkFreeCommandBuffers(this->vkState->device, this->vkState->commandPool, 1, &commandBuffer);
+
+        // The copy has completed, so the staging buffer can be used from the beginning again.
+        this->vkState->stagingBufferHead = 0;
     }
 
     void Renderer::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldImageLayout, VkImageLayout newImageLayout, uint32_t mipLevels)
@@ -1571,14 +2026,14 @@ namespace xr
         endOneTimeCommand(commandBuffer);
     }
 
-    XR_API void Renderer::copyBuffer(VkBuffer sourceBuffer, VkBuffer targetBuffer, VkDeviceSize size)
+    XR_API void Renderer::copyBuffer(VkBuffer sourceBuffer, VkBuffer targetBuffer, VkDeviceSize size, VkDeviceSize sourceOffset, VkDeviceSize targetOffset)
     {
         VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
         beginOneTimeCommand(commandBuffer);
 
         VkBufferCopy copyRegion = {};
-        copyRegion.srcOffset = 0;
-        copyRegion.dstOffset = 0;
+        copyRegion.srcOffset = sourceOffset;
+        copyRegion.dstOffset = targetOffset;
         copyRegion.size = size;
 
         vkCmdCopyBuffer(commandBuffer, sourceBuffer, targetBuffer, 1, &copyRegion);
@@ -1586,21 +2041,21 @@ namespace xr
         endOneTimeCommand(commandBuffer);
     }
 
-    XR_API void Renderer::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+    XR_API void Renderer::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize bufferOffset, int32_t imageOffsetY, int32_t imageOffsetX)
     {
         VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
         beginOneTimeCommand(commandBuffer);
 
         VkBufferImageCopy region = {};
-        region.bufferOffset = 0;
+        region.bufferOffset = bufferOffset;
         region.bufferRowLength = 0;
         region.bufferImageHeight = 0;
         region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         region.imageSubresource.mipLevel = 0;
         region.imageSubresource.baseArrayLayer = 0;
         region.imageSubresource.layerCount = 1;
-        region.imageOffset.x = 0;
-        region.imageOffset.y = 0;
+        region.imageOffset.x = imageOffsetX;
+        region.imageOffset.y = imageOffsetY;
         region.imageOffset.z = 0;
         region.imageExtent.width = width;
         region.imageExtent.height = height;
@@ -1611,404 +2066,1927 @@ namespace xr
         endOneTimeCommand(commandBuffer);
     }
 
-    XR_API void Renderer::initVertexBuffer(Model *model)
+    XR_API void Renderer::initStagingBuffer(VkDeviceSize size)
     {
-        VkDeviceSize size = sizeof(model->vertices[0]) * model->vertices.size();
         VkBufferUsageFlags stagingBufferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         VkMemoryPropertyFlags stagingMemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-        VkBuffer stagingBuffer = VK_NULL_HANDLE;
-        VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+        createBuffer(size, stagingBufferUsage, stagingMemoryProperties, &(this->vkState->stagingBuffer), &(this->vkState->stagingBufferAllocation));
 
-        createBuffer(size, stagingBufferUsage, stagingMemoryProperties, &stagingBuffer, &stagingBufferMemory);
+        this->vkState->stagingBufferSize = size;
+        this->vkState->stagingBufferHead = 0;
+        this->vkState->stagedBytes = 0;
+        this->vkState->stagingChunkCount = 0;
+        this->vkState->uploadSubmitCount = 0;
+
+        VkFenceCreateInfo fenceCreateInfo = {};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.pNext = nullptr;
+        fenceCreateInfo.flags = 0;
 
-        void *stagingBufferData = nullptr;
-        VkResult result = vkMapMemory(this->vkState->device, stagingBufferMemory, 0, size, 0, &stagingBufferData);
+        VkResult result = vkCreateFence(this->vkState->device, &fenceCreateInfo, nullptr, &(this->vkState->uploadFence));
         CHECK_ERROR(result);
 
-        memcpy(stagingBufferData, model->vertices.data(), (size_t)size);
-        vkUnmapMemory(this->vkState->device, stagingBufferMemory);
+        if (this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
+        {
+            VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphoreCreateInfo.pNext = nullptr;
+            semaphoreCreateInfo.flags = 0;
+
+            result = vkCreateSemaphore(this->vkState->device, &semaphoreCreateInfo, nullptr, &(this->vkState->uploadSemaphore));
+            CHECK_ERROR(result);
+        }
+    }
+
+    XR_API void Renderer::destroyStagingBuffer()
+    {
+        waitForUploadBatch();
+
+        logf("---------- Staging Buffer ----------");
+        logf("Size\t: %llu bytes", static_cast<unsigned long long>(this->vkState->stagingBufferSize));
+        logf("Staged\t: %llu bytes in %d chunks", static_cast<unsigned long long>(this->vkState->stagedBytes), this->vkState->stagingChunkCount);
+        logf("Batches\t: %d submits", this->vkState->uploadSubmitCount);
 
-        VkBufferUsageFlags vertexBufferUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-        VkMemoryPropertyFlags vertexMemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        vkDestroyFence(this->vkState->device, this->vkState->uploadFence, nullptr);
+        this->vkState->uploadFence = VK_NULL_HANDLE;
+
+        if (this->vkState->uploadSemaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(this->vkState->device, this->vkState->uploadSemaphore, nullptr);
+            this->vkState->uploadSemaphore = VK_NULL_HANDLE;
+        }
 
-        createBuffer(size, vertexBufferUsage, vertexMemoryProperties, &(model->vertexBuffer), &(model->vertexBufferMemory));
-        copyBuffer(stagingBuffer, model->vertexBuffer, size);
-        vkDestroyBuffer(this->vkState->device, stagingBuffer, nullptr);
-        vkFreeMemory(this->vkState->device, stagingBufferMemory, nullptr);
+        destroyBuffer(&(this->vkState->stagingBuffer), &(this->vkState->stagingBufferAllocation));
+        this->vkState->stagingBufferSize = 0;
+        this->vkState->stagingBufferHead = 0;
     }
 
-    XR_API void Renderer::destroyVertexBuffer(Model *model)
+    XR_API void Renderer::beginUploadBatch()
     {
-        vkDestroyBuffer(this->vkState->device, model->vertexBuffer, nullptr);
-        vkFreeMemory(this->vkState->device, model->vertexBufferMemory, nullptr);
-        model->vertexBuffer = VK_NULL_HANDLE;
-        model->vertexBufferMemory = VK_NULL_HANDLE;
+        assert(!this->vkState->isUploadBatchOpen && "Upload batch is already open.");
+
+        // The previous batch owns the staging buffer until it has completed.
+        waitForUploadBatch();
+
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.pNext = nullptr;
+        commandBufferAllocateInfo.commandPool = this->vkState->transferCommandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+
+        VkResult result = vkAllocateCommandBuffers(this->vkState->device, &commandBufferAllocateInfo, &(this->vkState->uploadCommandBuffer));
+        CHECK_ERROR(result);
+
+        VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        commandBufferBeginInfo.pNext = nullptr;
+        commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        commandBufferBeginInfo.pInheritanceInfo = nullptr;
+
+        result = vkBeginCommandBuffer(this->vkState->uploadCommandBuffer, &commandBufferBeginInfo);
+        CHECK_ERROR(result);
+
+        if (!this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
+        {
+            this->vkState->uploadGraphicsCommandBuffer = this->vkState->uploadCommandBuffer;
+        }
+        else
+        {
+            commandBufferAllocateInfo.commandPool = this->vkState->commandPool;
+
+            result = vkAllocateCommandBuffers(this->vkState->device, &commandBufferAllocateInfo, &(this->vkState->uploadGraphicsCommandBuffer));
+            CHECK_ERROR(result);
+
+            result = vkBeginCommandBuffer(this->vkState->uploadGraphicsCommandBuffer, &commandBufferBeginInfo);
+            CHECK_ERROR(result);
+        }
+
+        this->vkState->isUploadBatchOpen = true;
     }
 
-    XR_API void Renderer::initIndexBuffer(Model *model)
+    XR_API void Renderer::submitUploadBatch()
     {
-        VkDeviceSize size = sizeof(model->vertexIndices[0]) * model->vertexIndices.size();
-        VkBufferUsageFlags stagingBufferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        VkMemoryPropertyFlags stagingMemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        if (!this->vkState->isUploadBatchOpen)
+        {
+            return;
+        }
+
+        VkResult result = VK_SUCCESS;
+
+        if (!this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
+        {
+            // Buffer copies have no barrier of their own, make them visible to the vertex input of later frames.
+            // Textures are covered by the layout transition recorded in generateMipmaps.
+            VkMemoryBarrier memoryBarrier = {};
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.pNext = nullptr;
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
 
-        VkBuffer stagingBuffer = VK_NULL_HANDLE;
-        VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+            vkCmdPipelineBarrier(
+                this->vkState->uploadCommandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                0,
+                1,
+                &memoryBarrier,
+                0,
+                nullptr,
+                0,
+                nullptr
+            );
+        }
+        else
+        {
+            // Transfer queue part, its releases are matched by the acquires at the start of the graphics part.
+            result = vkEndCommandBuffer(this->vkState->uploadCommandBuffer);
+            CHECK_ERROR(result);
 
-        createBuffer(size, stagingBufferUsage, stagingMemoryProperties, &stagingBuffer, &stagingBufferMemory);
+            VkSubmitInfo transferSubmitInfo = {};
+            transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            transferSubmitInfo.pNext = nullptr;
+            transferSubmitInfo.waitSemaphoreCount = 0;
+            transferSubmitInfo.pWaitSemaphores = nullptr;
+            transferSubmitInfo.pWaitDstStageMask = nullptr;
+            transferSubmitInfo.commandBufferCount = 1;
+            transferSubmitInfo.pCommandBuffers = &(this->vkState->uploadCommandBuffer);
+            transferSubmitInfo.signalSemaphoreCount = 1;
+            transferSubmitInfo.pSignalSemaphores = &(this->vkState->uploadSemaphore);
+
+            result = vkQueueSubmit(this->vkState->transferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE);
+            CHECK_ERROR(result);
+        }
 
-        void *stagingBufferData = nullptr;
-        VkResult result = vkMapMemory(this->vkState->device, stagingBufferMemory, 0, size, 0, &stagingBufferData);
+        result = vkEndCommandBuffer(this->vkState->uploadGraphicsCommandBuffer);
         CHECK_ERROR(result);
 
-        memcpy(stagingBufferData, model->vertexIndices.data(), (size_t)size);
-        vkUnmapMemory(this->vkState->device, stagingBufferMemory);
+        VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
 
-        VkBufferUsageFlags indexBufferUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-        VkMemoryPropertyFlags indexMemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = nullptr;
+        submitInfo.waitSemaphoreCount = this->vkState->queueFamilyIndices.hasSeparateTransferQueue ? 1 : 0;
+        submitInfo.pWaitSemaphores = &(this->vkState->uploadSemaphore);
+        submitInfo.pWaitDstStageMask = &waitStageMask;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &(this->vkState->uploadGraphicsCommandBuffer);
+        submitInfo.signalSemaphoreCount = 0;
+        submitInfo.pSignalSemaphores = nullptr;
+
+        result = vkResetFences(this->vkState->device, 1, &(this->vkState->uploadFence));
+        CHECK_ERROR(result);
 
-        createBuffer(size, indexBufferUsage, indexMemoryProperties, &(model->indexBuffer), &(model->indexBufferMemory));
-        copyBuffer(stagingBuffer, model->indexBuffer, size);
-        vkDestroyBuffer(this->vkState->device, stagingBuffer, nullptr);
-        vkFreeMemory(this->vkState->device, stagingBufferMemory, nullptr);
+        result = vkQueueSubmit(this->vkState->graphicsQueue, 1, &submitInfo, this->vkState->uploadFence);
+        CHECK_ERROR(result);
+
+        this->vkState->isUploadBatchOpen = false;
+        this->vkState->isUploadBatchPending = true;
+        ++this->vkState->uploadSubmitCount;
     }
 
-    XR_API void Renderer::destroyIndexBuffer(Model *model)
+    XR_API bool Renderer::isUploadBatchComplete()
     {
-        vkDestroyBuffer(this->vkState->device, model->indexBuffer, nullptr);
-        vkFreeMemory(this->vkState->device, model->indexBufferMemory, nullptr);
-        model->indexBuffer = VK_NULL_HANDLE;
-        model->indexBufferMemory = VK_NULL_HANDLE;
+        if (!this->vkState->isUploadBatchPending)
+        {
+            return !this->vkState->isUploadBatchOpen;
+        }
+
+        return vkGetFenceStatus(this->vkState->device, this->vkState->uploadFence) == VK_SUCCESS;
     }
 
-    XR_API void Renderer::initUniformBuffers(Model *model)
+    XR_API void Renderer::waitForUploadBatch()
     {
-        VkDeviceSize size = sizeof(xr::UniformBufferObject);
-        VkBufferUsageFlags uniformBufferUsage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        VkMemoryPropertyFlags uniformMemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        if (!this->vkState->isUploadBatchPending)
+        {
+            return;
+        }
 
-        model->uniformBuffers.resize(this->vkState->swapchainImages.size());
-        model->uniformBuffersMemory.resize(this->vkState->swapchainImages.size());
+        // The fence is signaled by the graphics part, which waited on the transfer part.
+        VkResult result = vkWaitForFences(this->vkState->device, 1, &(this->vkState->uploadFence), VK_TRUE, UINT64_MAX);
+        CHECK_ERROR(result);
 
-        for (size_t counter = 0; counter < this->vkState->swapchainImages.size(); ++counter)
+        if (this->vkState->uploadGraphicsCommandBuffer != this->vkState->uploadCommandBuffer)
         {
-            createBuffer(size, uniformBufferUsage, uniformMemoryProperties, &(model->uniformBuffers[counter]), &(model->uniformBuffersMemory[counter]));
+            vkFreeCommandBuffers(this->vkState->device, this->vkState->commandPool, 1, &(this->vkState->uploadGraphicsCommandBuffer));
         }
+
+        vkFreeCommandBuffers(this->vkState->device, this->vkState->transferCommandPool, 1, &(this->vkState->uploadCommandBuffer));
+
+        this->vkState->uploadCommandBuffer = VK_NULL_HANDLE;
+        this->vkState->uploadGraphicsCommandBuffer = VK_NULL_HANDLE;
+        this->vkState->isUploadBatchPending = false;
+        this->vkState->stagingBufferHead = 0;
     }
 
-    XR_API void Renderer::destroyUniformBuffers(Model *model)
+    void Renderer::transferBufferOwnership(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
     {
-        for (size_t counter = 0; counter < this->vkState->swapchainImages.size(); ++counter)
+        if (!this->vkState->isUploadBatchOpen || !this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
         {
-            vkDestroyBuffer(this->vkState->device, model->uniformBuffers[counter], nullptr);
-            vkFreeMemory(this->vkState->device, model->uniformBuffersMemory[counter], nullptr);
+            return;
         }
 
-        model->uniformBuffers.clear();
-        model->uniformBuffersMemory.clear();
+        VkBufferMemoryBarrier bufferMemoryBarrier = {};
+        bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferMemoryBarrier.pNext = nullptr;
+        bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferMemoryBarrier.dstAccessMask = 0;
+        bufferMemoryBarrier.srcQueueFamilyIndex = this->vkState->queueFamilyIndices.transferFamilyIndex;
+        bufferMemoryBarrier.dstQueueFamilyIndex = this->vkState->queueFamilyIndices.graphicsFamilyIndex;
+        bufferMemoryBarrier.buffer = buffer;
+        bufferMemoryBarrier.offset = offset;
+        bufferMemoryBarrier.size = size;
+
+        // Release on the transfer queue, dstAccessMask is ignored there.
+        vkCmdPipelineBarrier(
+            this->vkState->uploadCommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &bufferMemoryBarrier,
+            0,
+            nullptr
+        );
+
+        // Acquire on the graphics queue with the same queue families and range, srcAccessMask is ignored there.
+        bufferMemoryBarrier.srcAccessMask = 0;
+        bufferMemoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            this->vkState->uploadGraphicsCommandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &bufferMemoryBarrier,
+            0,
+            nullptr
+        );
     }
 
-    XR_API void Renderer::initDescriptorPool(size_t models)
+    void Renderer::transferImageOwnership(VkImage image, VkImageLayout imageLayout, uint32_t mipLevels)
     {
-        VkDescriptorPoolSize uboPoolSize = {};
-        uboPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        uboPoolSize.descriptorCount = static_cast<uint32_t>(this->vkState->swapchainImages.size() * models);
+        if (!this->vkState->isUploadBatchOpen || !this->vkState->queueFamilyIndices.hasSeparateTransferQueue)
+        {
+            return;
+        }
 
-        VkDescriptorPoolSize samplerPoolSize = {};
-        samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        samplerPoolSize.descriptorCount = static_cast<uint32_t>(this->vkState->swapchainImages.size() * models);
-        ;
+        // The layout is kept, both halves of the transfer have to describe the same transition.
+        VkImageMemoryBarrier imageMemoryBarrier = {};
+        imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageMemoryBarrier.pNext = nullptr;
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageMemoryBarrier.dstAccessMask = 0;
+        imageMemoryBarrier.oldLayout = imageLayout;
+        imageMemoryBarrier.newLayout = imageLayout;
+        imageMemoryBarrier.srcQueueFamilyIndex = this->vkState->queueFamilyIndices.transferFamilyIndex;
+        imageMemoryBarrier.dstQueueFamilyIndex = this->vkState->queueFamilyIndices.graphicsFamilyIndex;
+        imageMemoryBarrier.image = image;
+        imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
+        imageMemoryBarrier.subresourceRange.levelCount = mipLevels;
+        imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
+        imageMemoryBarrier.subresourceRange.layerCount = 1;
 
-        std::array<VkDescriptorPoolSize, 2> poolSizes = { uboPoolSize, samplerPoolSize };
+        vkCmdPipelineBarrier(
+            this->vkState->uploadCommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &imageMemoryBarrier
+        );
 
-        VkDescriptorPoolCreateInfo poolCreateInfo = {};
-        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolCreateInfo.pNext = nullptr;
-        poolCreateInfo.flags = 0;
-        // If you want to explicitly destroy the descriptorSet, then set this bit
-        // else you will get runtime error while destroying the descriptorSet.
-        // We are not going to used this for now.
-        // poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        poolCreateInfo.maxSets = static_cast<uint32_t>(this->vkState->swapchainImages.size() * models);
-        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-        poolCreateInfo.pPoolSizes = poolSizes.data();
+        imageMemoryBarrier.srcAccessMask = 0;
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 
-        VkResult result = vkCreateDescriptorPool(this->vkState->device, &poolCreateInfo, nullptr, &(this->vkState->descriptorPool));
-        CHECK_ERROR(result);
+        vkCmdPipelineBarrier(
+            this->vkState->uploadGraphicsCommandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &imageMemoryBarrier
+        );
     }
 
-    XR_API void Renderer::destroyDescriptorPool()
+    void Renderer::flushUploadBatch()
     {
-        vkDestroyDescriptorPool(this->vkState->device, this->vkState->descriptorPool, nullptr);
-        this->vkState->descriptorPool = VK_NULL_HANDLE;
+        if (!this->vkState->isUploadBatchOpen)
+        {
+            return;
+        }
+
+        submitUploadBatch();
+        waitForUploadBatch();
+        beginUploadBatch();
     }
 
-    XR_API void Renderer::initDescriptorSets(std::vector<Model *> models)
+    VkDeviceSize Renderer::acquireStagingRange(VkDeviceSize size)
     {
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts(this->vkState->swapchainImages.size(), this->vkState->descriptorSetLayout);
+        assert(size <= this->vkState->stagingBufferSize && "Staging range is larger than the staging buffer.");
 
-        for (size_t index = 0; index < models.size(); ++index)
-        {
-            Model *model = models[index];
-            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
-            descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            descriptorSetAllocateInfo.pNext = nullptr;
-            descriptorSetAllocateInfo.descriptorPool = this->vkState->descriptorPool;
-            descriptorSetAllocateInfo.descriptorSetCount = static_cast<uint32_t>(this->vkState->swapchainImages.size());
-            descriptorSetAllocateInfo.pSetLayouts = descriptorSetLayouts.data();
+        // 16 bytes satisfies the bufferOffset alignment of buffer copies and of every texel size used for images.
+        VkDeviceSize offset = (this->vkState->stagingBufferHead + 15) / 16 * 16;
 
-            model->descriptorSets.resize(this->vkState->swapchainImages.size());
+        if (offset + size > this->vkState->stagingBufferSize)
+        {
+            // The copies recorded so far still read from the staging buffer, they have to complete before it is reused.
+            flushUploadBatch();
+            offset = 0;
+        }
 
-            VkResult result = vkAllocateDescriptorSets(this->vkState->device, &descriptorSetAllocateInfo, model->descriptorSets.data());
-            CHECK_ERROR(result);
+        this->vkState->stagingBufferHead = offset + size;
 
-            for (size_t counter = 0; counter < this->vkState->swapchainImages.size(); ++counter)
-            {
-                VkDescriptorBufferInfo descriptorBufferInfo = {};
-                descriptorBufferInfo.buffer = model->uniformBuffers[counter];
-                descriptorBufferInfo.offset = 0;
-                descriptorBufferInfo.range = sizeof(xr::UniformBufferObject);
-
-                VkDescriptorImageInfo descriptorImageInfo = {};
-                descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                descriptorImageInfo.imageView = model->textureImageView;
-                descriptorImageInfo.sampler = model->textureSampler;
-
-                VkWriteDescriptorSet uniformBudderDescriptorWrite = {};
-                uniformBudderDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                uniformBudderDescriptorWrite.pNext = nullptr;
-                uniformBudderDescriptorWrite.dstSet = model->descriptorSets[counter];
-                uniformBudderDescriptorWrite.dstBinding = 0;
-                uniformBudderDescriptorWrite.dstArrayElement = 0;
-                uniformBudderDescriptorWrite.descriptorCount = 1;
-                uniformBudderDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                uniformBudderDescriptorWrite.pImageInfo = nullptr;
-                uniformBudderDescriptorWrite.pBufferInfo = &descriptorBufferInfo;
-                uniformBudderDescriptorWrite.pTexelBufferView = nullptr;
-
-                VkWriteDescriptorSet textureImageDescriptorWrite = {};
-                textureImageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                textureImageDescriptorWrite.pNext = nullptr;
-                textureImageDescriptorWrite.dstSet = model->descriptorSets[counter];
-                textureImageDescriptorWrite.dstBinding = 1;
-                textureImageDescriptorWrite.dstArrayElement = 0;
-                textureImageDescriptorWrite.descriptorCount = 1;
-                textureImageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                textureImageDescriptorWrite.pImageInfo = &descriptorImageInfo;
-                textureImageDescriptorWrite.pBufferInfo = nullptr;
-                textureImageDescriptorWrite.pTexelBufferView = nullptr;
-
-                std::array<VkWriteDescriptorSet, 2> descriptorWrites = { uniformBudderDescriptorWrite, textureImageDescriptorWrite };
-                vkUpdateDescriptorSets(this->vkState->device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-            }
-        }
+        return offset;
     }
 
-    XR_API void Renderer::destroyDescriptorSets(std::vector<Model *> models)
+    void Renderer::uploadToBuffer(VkBuffer targetBuffer, VkDeviceSize targetOffset, const void *data, VkDeviceSize size)
     {
-        for (size_t index = 0; index < models.size(); ++index)
+        const char *source = static_cast<const char *>(data);
+        char *stagingData = static_cast<char *>(this->vkState->stagingBufferAllocation.mappedData);
+
+        for (VkDeviceSize uploadedSize = 0; uploadedSize < size;)
         {
-            Model *model = models[index];
+            VkDeviceSize chunkSize = std::min(size - uploadedSize, this->vkState->stagingBufferSize);
+            VkDeviceSize stagingOffset = acquireStagingRange(chunkSize);
 
-            // If you want to explicitly destroy the descriptorSet, then set
-            // poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
-            // bit in VkDescriptorPoolCreateInfo else you will get runtime error
-            // while destroying the descriptorSet.
-            // We are not going to used this for now.
-            // vkFreeDescriptorSets(
-            //     this->vkState->device,
-            //     this->vkState->descriptorPool,
-            //     model->descriptorSets.size(),
-            //     model->descriptorSets.data()
-            // );
+            memcpy(stagingData + stagingOffset, source + uploadedSize, (size_t)chunkSize);
+            copyBuffer(this->vkState->stagingBuffer, targetBuffer, chunkSize, stagingOffset, targetOffset + uploadedSize);
 
-            model->descriptorSets.clear();
+            uploadedSize += chunkSize;
+            this->vkState->stagedBytes += chunkSize;
+            ++this->vkState->stagingChunkCount;
         }
     }
 
-    XR_API void Renderer::initCommandBuffers(std::vector<Model *> models)
+    void Renderer::uploadToImage(VkImage image, const void *pixels, uint32_t width, uint32_t height, uint32_t bytesPerPixel)
     {
-        this->vkState->commandBuffers.resize(this->vkState->framebuffers.size());
-
-        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
-        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        commandBufferAllocateInfo.pNext = nullptr;
-        commandBufferAllocateInfo.commandPool = this->vkState->commandPool;
-        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        commandBufferAllocateInfo.commandBufferCount = static_cast<uint32_t>(this->vkState->commandBuffers.size());
+        const char *source = static_cast<const char *>(pixels);
+        char *stagingData = static_cast<char *>(this->vkState->stagingBufferAllocation.mappedData);
+        VkDeviceSize rowSize = static_cast<VkDeviceSize>(width) * bytesPerPixel;
 
-        VkResult result = vkAllocateCommandBuffers(this->vkState->device, &commandBufferAllocateInfo, this->vkState->commandBuffers.data());
-        CHECK_ERROR(result);
+        // Images are split on whole rows so every chunk is a plain rectangle of the base level.
+        uint32_t rowsPerChunk = static_cast<uint32_t>(std::min<VkDeviceSize>(this->vkState->stagingBufferSize / rowSize, height));
 
-        for (uint32_t counter = 0; counter < this->vkState->commandBuffers.size(); ++counter)
+        if (rowsPerChunk == 0)
         {
-            VkCommandBufferBeginInfo commandBufferBeginInfo = {};
-            commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            commandBufferBeginInfo.pNext = nullptr;
-            commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-            commandBufferBeginInfo.pInheritanceInfo = nullptr;
+            uploadImageRowSegments(image, pixels, width, height, bytesPerPixel);
+            return;
+        }
 
-            vkBeginCommandBuffer(this->vkState->commandBuffers[counter], &commandBufferBeginInfo);
+        for (uint32_t uploadedRows = 0; uploadedRows < height;)
+        {
+            uint32_t chunkRows = std::min(height - uploadedRows, rowsPerChunk);
+            VkDeviceSize chunkSize = rowSize * chunkRows;
+            VkDeviceSize stagingOffset = acquireStagingRange(chunkSize);
 
-            VkRect2D renderArea = {};
-            renderArea.offset.x = 0;
-            renderArea.offset.y = 0;
-            renderArea.extent.width = this->vkState->surfaceSize.width;
-            renderArea.extent.height = this->vkState->surfaceSize.height;
+            memcpy(stagingData + stagingOffset, source + (rowSize * uploadedRows), (size_t)chunkSize);
+            copyBufferToImage(this->vkState->stagingBuffer, image, width, chunkRows, stagingOffset, static_cast<int32_t>(uploadedRows));
 
-            std::array<VkClearValue, 2> clearValue = {};
-            clearValue[0].color = { 0.0f, 0.0f, 0.0f, 1.0f }; // {r, g, b, a}
-            clearValue[1].depthStencil = { 1.0f, 0 };         // {depth, stencil}
+            uploadedRows += chunkRows;
+            this->vkState->stagedBytes += chunkSize;
+            ++this->vkState->stagingChunkCount;
+        }
+    }
 
-            VkRenderPassBeginInfo renderPassBeginInfo = {};
-            renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassBeginInfo.pNext = nullptr;
-            renderPassBeginInfo.renderPass = this->vkState->renderPass;
-            renderPassBeginInfo.framebuffer = this->vkState->framebuffers[counter];
-            renderPassBeginInfo.renderArea = renderArea;
-            renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValue.size());
-            renderPassBeginInfo.pClearValues = clearValue.data();
+    void Renderer::uploadImageRowSegments(VkImage image, const void *pixels, uint32_t width, uint32_t height, uint32_t bytesPerPixel)
+    {
+        const char *source = static_cast<const char *>(pixels);
+        char *stagingData = static_cast<char *>(this->vkState->stagingBufferAllocation.mappedData);
+        VkDeviceSize rowSize = static_cast<VkDeviceSize>(width) * bytesPerPixel;
 
-            vkCmdBeginRenderPass(this->vkState->commandBuffers[counter], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-            vkCmdBindPipeline(this->vkState->commandBuffers[counter], VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->pipeline);
+        // A row wider than the staging buffer is copied as segments of whole texels, one row at a time.
+        uint32_t texelsPerSegment = static_cast<uint32_t>(std::min<VkDeviceSize>(this->vkState->stagingBufferSize / bytesPerPixel, width));
 
-            VkDeviceSize offset = { 0 };
+        if (texelsPerSegment == 0)
+        {
+            logf("Staging buffer of %llu bytes cannot hold one texel, image upload skipped", static_cast<unsigned long long>(this->vkState->stagingBufferSize));
+            return;
+        }
 
-            for (size_t index = 0; index < models.size(); ++index)
+        for (uint32_t row = 0; row < height; ++row)
+        {
+            for (uint32_t uploadedTexels = 0; uploadedTexels < width;)
             {
-                Model *model = models[index];
-                vkCmdBindVertexBuffers(this->vkState->commandBuffers[counter], 0, 1, &(model->vertexBuffer), &offset);
-                vkCmdBindIndexBuffer(this->vkState->commandBuffers[counter], model->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-                vkCmdBindDescriptorSets(
-                    this->vkState->commandBuffers[counter],
-                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    this->vkState->pipelineLayout,
-                    0,
-                    1,
-                    &(model->descriptorSets[counter]),
-                    0,
-                    nullptr
+                uint32_t segmentTexels = std::min(width - uploadedTexels, texelsPerSegment);
+                VkDeviceSize segmentSize = static_cast<VkDeviceSize>(segmentTexels) * bytesPerPixel;
+                VkDeviceSize stagingOffset = acquireStagingRange(segmentSize);
+
+                memcpy(stagingData + stagingOffset, source + (rowSize * row) + (static_cast<VkDeviceSize>(uploadedTexels) * bytesPerPixel), (size_t)segmentSize);
+                copyBufferToImage(
+                    this->vkState->stagingBuffer, image, segmentTexels, 1, stagingOffset, static_cast<int32_t>(row), static_cast<int32_t>(uploadedTexels)
                 );
 
-                vkCmdDrawIndexed(this->vkState->commandBuffers[counter], static_cast<uint32_t>(model->vertexIndices.size()), 1, 0, 0, 0);
+                uploadedTexels += segmentTexels;
+                this->vkState->stagedBytes += segmentSize;
+                ++this->vkState->stagingChunkCount;
             }
+        }
+    }
 
-            vkCmdEndRenderPass(this->vkState->commandBuffers[counter]);
+    XR_API void Renderer::initGeometryBuffers(VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity)
+    {
+        // Transfer source is needed to copy the old content over when a buffer has to grow.
+        VkBufferUsageFlags transferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
-            VkResult result = vkEndCommandBuffer(this->vkState->commandBuffers[counter]);
-            CHECK_ERROR(result);
-        }
+        createGeometryBuffer(&(this->vkState->vertexGeometryBuffer), vertexCapacity, transferUsage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        createGeometryBuffer(&(this->vkState->indexGeometryBuffer), indexCapacity, transferUsage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
     }
 
-    XR_API void Renderer::destroyCommandBuffers()
+    XR_API void Renderer::destroyGeometryBuffers()
     {
-        vkFreeCommandBuffers(
-            this->vkState->device, this->vkState->commandPool, static_cast<uint32_t>(this->vkState->commandBuffers.size()), this->vkState->commandBuffers.data()
+        logf("---------- Geometry Buffers ----------");
+        logf(
+            "Vertex\t: %llu / %llu bytes in %d ranges",
+            static_cast<unsigned long long>(this->vkState->vertexGeometryBuffer.usedSize),
+            static_cast<unsigned long long>(this->vkState->vertexGeometryBuffer.capacity),
+            this->vkState->vertexGeometryBuffer.allocationCount
+        );
+        logf(
+            "Index\t: %llu / %llu bytes in %d ranges",
+            static_cast<unsigned long long>(this->vkState->indexGeometryBuffer.usedSize),
+            static_cast<unsigned long long>(this->vkState->indexGeometryBuffer.capacity),
+            this->vkState->indexGeometryBuffer.allocationCount
         );
 
-        this->vkState->commandBuffers.clear();
+        // The device is idle by now, the batch copying into the last grown buffer is the only work that may be left.
+        waitForUploadBatch();
+        releaseRetiredBuffers(UINT64_MAX);
+
+        destroyBuffer(&(this->vkState->vertexGeometryBuffer.buffer), &(this->vkState->vertexGeometryBuffer.bufferAllocation));
+        destroyBuffer(&(this->vkState->indexGeometryBuffer.buffer), &(this->vkState->indexGeometryBuffer.bufferAllocation));
+
+        this->vkState->vertexGeometryBuffer.reset(0);
+        this->vkState->indexGeometryBuffer.reset(0);
     }
 
-    XR_API void Renderer::initSynchronizations()
+    void Renderer::createGeometryBuffer(GeometryBuffer *geometryBuffer, VkDeviceSize capacity, VkBufferUsageFlags usage)
     {
-        this->vkState->imageAvailableSemaphores.resize(this->vkState->MAX_FRAMES_IN_FLIGHT);
-        this->vkState->renderFinishedSemaphores.resize(this->vkState->MAX_FRAMES_IN_FLIGHT);
-        this->vkState->inFlightFences.resize(this->vkState->MAX_FRAMES_IN_FLIGHT);
+        geometryBuffer->usage = usage;
+        geometryBuffer->reset(capacity);
 
-        VkSemaphoreCreateInfo semaphoreCreateInfo = {};
-        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        semaphoreCreateInfo.pNext = nullptr;
-        semaphoreCreateInfo.flags = 0;
+        createBuffer(capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &(geometryBuffer->buffer), &(geometryBuffer->bufferAllocation));
+    }
 
-        VkFenceCreateInfo fenceCreateInfo = {};
-        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceCreateInfo.pNext = nullptr;
-        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    void Renderer::growGeometryBuffer(GeometryBuffer *geometryBuffer, VkDeviceSize requiredSize)
+    {
+        VkDeviceSize newCapacity = std::max(geometryBuffer->capacity * 2, geometryBuffer->capacity + requiredSize);
 
-        for (size_t counter = 0; counter < this->vkState->MAX_FRAMES_IN_FLIGHT; ++counter)
-        {
-            VkResult result = vkCreateSemaphore(this->vkState->device, &semaphoreCreateInfo, nullptr, &this->vkState->imageAvailableSemaphores[counter]);
-            CHECK_ERROR(result);
+        logf(
+            "Growing geometry buffer from %llu to %llu bytes",
+            static_cast<unsigned long long>(geometryBuffer->capacity),
+            static_cast<unsigned long long>(newCapacity)
+        );
 
-            result = vkCreateSemaphore(this->vkState->device, &semaphoreCreateInfo, nullptr, &this->vkState->renderFinishedSemaphores[counter]);
-            CHECK_ERROR(result);
+        VkBuffer newBuffer = VK_NULL_HANDLE;
+        MemoryAllocation newBufferAllocation = {};
+        createBuffer(newCapacity, geometryBuffer->usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &newBuffer, &newBufferAllocation);
 
-            result = vkCreateFence(this->vkState->device, &fenceCreateInfo, nullptr, &(this->vkState->inFlightFences[counter]));
-            CHECK_ERROR(result);
+        // Offsets of existing ranges stay valid, so only the buffer handle changes. The copy closes the graphics part
+        // of the upload batch, after every write of the batch to the old buffer, and later writes to the new buffer
+        // only start with the next batch, once this one has completed. Nothing is waited on here: frames in flight
+        // keep drawing from the old buffer, which is retired instead of destroyed.
+        bool wasUploadBatchOpen = this->vkState->isUploadBatchOpen;
+
+        if (!wasUploadBatchOpen)
+        {
+            beginUploadBatch();
         }
-    }
 
-    XR_API void Renderer::destroySynchronizations()
-    {
-        for (size_t counter = 0; counter < this->vkState->MAX_FRAMES_IN_FLIGHT; ++counter)
+        if (geometryBuffer->capacity > 0)
         {
-            vkDestroySemaphore(this->vkState->device, this->vkState->imageAvailableSemaphores[counter], nullptr);
-            vkDestroySemaphore(this->vkState->device, this->vkState->renderFinishedSemaphores[counter], nullptr);
-            vkDestroyFence(this->vkState->device, this->vkState->inFlightFences[counter], nullptr);
+            VkCommandBuffer commandBuffer = this->vkState->uploadGraphicsCommandBuffer;
+
+            // Same queue copies into the old buffer and the ownership acquires of transfer queue writes come first.
+            VkMemoryBarrier memoryBarrier = {};
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.pNext = nullptr;
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                1,
+                &memoryBarrier,
+                0,
+                nullptr,
+                0,
+                nullptr
+            );
+
+            VkBufferCopy copyRegion = {};
+            copyRegion.srcOffset = 0;
+            copyRegion.dstOffset = 0;
+            copyRegion.size = geometryBuffer->capacity;
+
+            vkCmdCopyBuffer(commandBuffer, geometryBuffer->buffer, newBuffer, 1, &copyRegion);
+
+            // Frames submitted after the batch draw from the new buffer.
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                0,
+                1,
+                &memoryBarrier,
+                0,
+                nullptr,
+                0,
+                nullptr
+            );
         }
 
-        this->vkState->imageAvailableSemaphores.clear();
-        this->vkState->renderFinishedSemaphores.clear();
-        this->vkState->inFlightFences.clear();
-    }
+        submitUploadBatch();
+        retireBuffer(&(geometryBuffer->buffer), &(geometryBuffer->bufferAllocation));
 
-    XR_API void Renderer::recreateSwapChain(std::vector<Model *> models)
-    {
-        logf("---------- Recreate SwapChain --------");
-        cleanupSwapChain(models);
-        initSwapchain();
-        initSwapchainImageViews();
-        initRenderPass();
-        initGraphicsPiplineCache();
-        initGraphicsPipline();
-        initDepthStencilImage();
-        initMSAAColorImage();
-        initFrameBuffers();
+        geometryBuffer->buffer = newBuffer;
+        geometryBuffer->bufferAllocation = newBufferAllocation;
+        geometryBuffer->grow(newCapacity);
 
-        for (size_t index = 0; index < models.size(); ++index)
+        if (wasUploadBatchOpen)
         {
-            initUniformBuffers(models[index]);
+            beginUploadBatch();
         }
+    }
+
+    void Renderer::retireBuffer(VkBuffer *buffer, MemoryAllocation *bufferAllocation)
+    {
+        // Every frame submitted so far may use the buffer, the next one will not.
+        RetiredBuffer retiredBuffer = {};
+        retiredBuffer.buffer = *buffer;
+        retiredBuffer.bufferAllocation = *bufferAllocation;
+        retiredBuffer.lastFrameNumber = this->vkState->submittedFrameCount;
+
+        this->vkState->retiredBuffers.push_back(retiredBuffer);
 
-        initDescriptorPool(models.size());
-        initDescriptorSets(models);
-        initCommandBuffers(models);
-        initSynchronizations();
+        *buffer = VK_NULL_HANDLE;
+        *bufferAllocation = MemoryAllocation();
     }
 
-    XR_API void Renderer::cleanupSwapChain(std::vector<Model *> models)
+    void Renderer::releaseRetiredBuffers(uint64_t completedFrameNumber)
     {
-        waitForIdle();
-        destroySynchronizations();
-        destroyCommandBuffers();
-        destroyDescriptorSets(models);
-        destroyDescriptorPool();
+        // Work is submitted to the graphics queue in order, so a completed frame also completed every earlier frame
+        // and upload batch.
+        std::vector<RetiredBuffer> &retiredBuffers = this->vkState->retiredBuffers;
 
-        for (size_t index = 0; index < models.size(); ++index)
+        for (size_t index = 0; index < retiredBuffers.size();)
         {
-            destroyUniformBuffers(models[index]);
+            if (retiredBuffers[index].lastFrameNumber < completedFrameNumber)
+            {
+                destroyBuffer(&(retiredBuffers[index].buffer), &(retiredBuffers[index].bufferAllocation));
+                retiredBuffers[index] = retiredBuffers.back();
+                retiredBuffers.pop_back();
+            }
+            else
+            {
+                ++index;
+            }
         }
-
-        destroyFrameBuffers();
-        destroyMSAAColorImage();
-        destroyDepthStencilImage();
-        destroyGraphicsPipline();
-        destroyGraphicsPiplineCache();
-        destroyRenderPass();
-        destroySwapchainImageViews();
-        destroySwapchain();
     }
 
-    XR_API void Renderer::render(std::vector<Model *> models)
+    void Renderer::uploadGeometry(GeometryBuffer *geometryBuffer, GeometryAllocation *allocation, const void *data, VkDeviceSize size, VkDeviceSize stride)
     {
-        VkResult result = VK_SUCCESS;
+        // Aligning to the element stride keeps the range offset expressible as vertexOffset / firstIndex.
+        if (!geometryBuffer->allocate(size, stride, allocation))
+        {
+            growGeometryBuffer(geometryBuffer, size + stride);
 
-        // Update the current frame count at start as we might return in between and fail to update the counter
-        this->vkState->currentFrame = (this->vkState->currentFrame + 1) % this->vkState->MAX_FRAMES_IN_FLIGHT;
+            bool allocated = geometryBuffer->allocate(size, stride, allocation);
+            assert(allocated && "Not able to allocate geometry range.");
+        }
 
-        result = vkWaitForFences(this->vkState->device, 1, &(this->vkState->inFlightFences[this->vkState->currentFrame]), VK_TRUE, UINT64_MAX);
+        uploadToBuffer(geometryBuffer->buffer, allocation->offset, data, size);
+        transferBufferOwnership(geometryBuffer->buffer, allocation->offset, size);
+    }
+
+    XR_API void Renderer::initVertexBuffer(Model *model)
+    {
+        VkDeviceSize stride = sizeof(CompactVertex);
+        VkDeviceSize size = stride * model->vertexCount;
+
+        uploadGeometry(&(this->vkState->vertexGeometryBuffer), &(model->vertexAllocation), model->packedVertices, size, stride);
+        model->vertexOffset = static_cast<int32_t>(model->vertexAllocation.offset / stride);
+    }
+
+    XR_API void Renderer::destroyVertexBuffer(Model *model)
+    {
+        this->vkState->vertexGeometryBuffer.free(&(model->vertexAllocation));
+        model->vertexOffset = 0;
+    }
+
+    XR_API void Renderer::initIndexBuffer(Model *model)
+    {
+        // 16 and 32 bit indices share the buffer, firstIndex counts elements of the model's own index type
+        // from the start of the buffer, the range is aligned to that size.
+        bool isCompact = (model->indexType == VK_INDEX_TYPE_UINT16);
+        VkDeviceSize stride = isCompact ? sizeof(uint16_t) : sizeof(uint32_t);
+        VkDeviceSize size = stride * model->indexCount;
+
+        uploadGeometry(&(this->vkState->indexGeometryBuffer), &(model->indexAllocation), model->packedIndices, size, stride);
+        model->firstIndex = static_cast<uint32_t>(model->indexAllocation.offset / stride);
+    }
+
+    XR_API void Renderer::destroyIndexBuffer(Model *model)
+    {
+        this->vkState->indexGeometryBuffer.free(&(model->indexAllocation));
+        model->firstIndex = 0;
+    }
+
+    XR_API void Renderer::initUniformBuffers()
+    {
+        // Every frame region offset inside the buffer must be a multiple of minUniformBufferOffsetAlignment.
+        VkDeviceSize alignment = std::max<VkDeviceSize>(this->vkState->gpuDetails.properties.limits.minUniformBufferOffsetAlignment, 1);
+        VkDeviceSize cameraSize = sizeof(xr::CameraUniformBufferObject);
+
+        this->vkState->uniformFrameSize = (cameraSize + alignment - 1) / alignment * alignment;
+
+        VkDeviceSize size = this->vkState->uniformFrameSize * this->vkState->MAX_FRAMES_IN_FLIGHT;
+        VkBufferUsageFlags uniformBufferUsage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        VkMemoryPropertyFlags uniformMemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        createBuffer(size, uniformBufferUsage, uniformMemoryProperties, &(this->vkState->uniformRingBuffer), &(this->vkState->uniformRingBufferAllocation));
+
+        logf("---------- Uniform Ring Buffer ----------");
+        logf("Frame Size\t: %llu", static_cast<unsigned long long>(this->vkState->uniformFrameSize));
+        logf("Total Size\t: %llu", static_cast<unsigned long long>(size));
+        logf("---------- Uniform Ring Buffer End ----------");
+
+        // The instance stream is per frame data written by the host as well.
+        this->vkState->instanceBuffers.assign(this->vkState->MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+        this->vkState->instanceBufferAllocations.assign(this->vkState->MAX_FRAMES_IN_FLIGHT, MemoryAllocation());
+        this->vkState->instanceCapacities.assign(this->vkState->MAX_FRAMES_IN_FLIGHT, 0);
+
+        for (size_t frameIndex = 0; frameIndex < this->vkState->instanceBuffers.size(); ++frameIndex)
+        {
+            growInstanceBuffer(frameIndex, MIN_INSTANCE_CAPACITY);
+        }
+    }
+
+    XR_API void Renderer::destroyUniformBuffers()
+    {
+        for (size_t frameIndex = 0; frameIndex < this->vkState->instanceBuffers.size(); ++frameIndex)
+        {
+            destroyBuffer(&(this->vkState->instanceBuffers[frameIndex]), &(this->vkState->instanceBufferAllocations[frameIndex]));
+        }
+
+        this->vkState->instanceBuffers.clear();
+        this->vkState->instanceBufferAllocations.clear();
+        this->vkState->instanceCapacities.clear();
+
+        destroyBuffer(&(this->vkState->uniformRingBuffer), &(this->vkState->uniformRingBufferAllocation));
+        this->vkState->uniformFrameSize = 0;
+    }
+
+    void Renderer::growInstanceBuffer(size_t frameIndex, uint32_t instanceCount)
+    {
+        uint32_t capacity = std::max(this->vkState->instanceCapacities[frameIndex], MIN_INSTANCE_CAPACITY);
+
+        while (capacity < instanceCount)
+        {
+            capacity *= 2;
+        }
+
+        // Only this frame's buffer is replaced, its fence has signaled so no submitted work reads it any more.
+        // The other frames grow their own buffer when they come around, without waiting for the device.
+        destroyBuffer(&(this->vkState->instanceBuffers[frameIndex]), &(this->vkState->instanceBufferAllocations[frameIndex]));
+        createBuffer(
+            capacity * sizeof(xr::InstanceData),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &(this->vkState->instanceBuffers[frameIndex]),
+            &(this->vkState->instanceBufferAllocations[frameIndex])
+        );
+
+        // The frame's recording bound the destroyed buffer.
+        if (frameIndex < this->vkState->frameRecordings.size())
+        {
+            this->vkState->frameRecordings[frameIndex].instanceBuffer = VK_NULL_HANDLE;
+        }
+
+        this->vkState->instanceCapacities[frameIndex] = capacity;
+
+        logf("---------- Instance buffer capacity [frame %zu, %u instances] ----------", frameIndex, capacity);
+    }
+
+    XR_API void Renderer::initDescriptorPool(size_t models)
+    {
+        // A single dynamic uniform buffer descriptor is shared by every draw, only the texture sets scale with the scene.
+        VkDescriptorPoolSize uboPoolSize = {};
+        uboPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        uboPoolSize.descriptorCount = 1;
+
+        VkDescriptorPoolSize samplerPoolSize = {};
+        samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        // Only the initial capacity, streamed models that do not fit get their set from a chained pool.
+        this->vkState->textureDescriptorPoolCapacity = std::max<size_t>(models, 1);
+        this->vkState->textureDescriptorPoolUsedCount = 0;
+        samplerPoolSize.descriptorCount = static_cast<uint32_t>(this->vkState->textureDescriptorPoolCapacity);
+
+        std::array<VkDescriptorPoolSize, 2> poolSizes = { uboPoolSize, samplerPoolSize };
+
+        VkDescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.pNext = nullptr;
+        poolCreateInfo.flags = 0;
+        // If you want to explicitly destroy the descriptorSet, then set this bit
+        // else you will get runtime error while destroying the descriptorSet.
+        // We are not going to used this for now.
+        // poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        poolCreateInfo.maxSets = static_cast<uint32_t>(1 + this->vkState->textureDescriptorPoolCapacity);
+        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolCreateInfo.pPoolSizes = poolSizes.data();
+
+        VkResult result = vkCreateDescriptorPool(this->vkState->device, &poolCreateInfo, nullptr, &(this->vkState->descriptorPool));
+        CHECK_ERROR(result);
+    }
+
+    XR_API void Renderer::destroyDescriptorPool()
+    {
+        for (VkDescriptorPool textureDescriptorPool : this->vkState->textureDescriptorPools)
+        {
+            vkDestroyDescriptorPool(this->vkState->device, textureDescriptorPool, nullptr);
+        }
+
+        vkDestroyDescriptorPool(this->vkState->device, this->vkState->descriptorPool, nullptr);
+        this->vkState->descriptorPool = VK_NULL_HANDLE;
+        this->vkState->textureDescriptorPools.clear();
+        this->vkState->textureDescriptorPoolCapacity = 0;
+        this->vkState->textureDescriptorPoolUsedCount = 0;
+    }
+
+    void Renderer::growTextureDescriptorPool()
+    {
+        // Sets already handed out stay valid, a full pool is kept and a larger one is chained after it.
+        size_t capacity = this->vkState->textureDescriptorPoolCapacity * 2;
+
+        VkDescriptorPoolSize samplerPoolSize = {};
+        samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        samplerPoolSize.descriptorCount = static_cast<uint32_t>(capacity);
+
+        VkDescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.pNext = nullptr;
+        poolCreateInfo.flags = 0;
+        poolCreateInfo.maxSets = static_cast<uint32_t>(capacity);
+        poolCreateInfo.poolSizeCount = 1;
+        poolCreateInfo.pPoolSizes = &samplerPoolSize;
+
+        VkDescriptorPool textureDescriptorPool = VK_NULL_HANDLE;
+        VkResult result = vkCreateDescriptorPool(this->vkState->device, &poolCreateInfo, nullptr, &textureDescriptorPool);
+        CHECK_ERROR(result);
+
+        this->vkState->textureDescriptorPools.push_back(textureDescriptorPool);
+        this->vkState->textureDescriptorPoolCapacity = capacity;
+        this->vkState->textureDescriptorPoolUsedCount = 0;
+
+        logf("---------- Texture descriptor pool chained [%zu sets] ----------", capacity);
+    }
+
+    XR_API void Renderer::initDescriptorSets(std::vector<Model *> models)
+    {
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+            descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.pNext = nullptr;
+            descriptorSetAllocateInfo.descriptorPool = this->vkState->descriptorPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts = &(this->vkState->descriptorSetLayout);
+
+            VkResult result = vkAllocateDescriptorSets(this->vkState->device, &descriptorSetAllocateInfo, &(this->vkState->uniformDescriptorSet));
+            CHECK_ERROR(result);
+
+            // The offset is supplied at bind time as dynamic offset, the range covers one frame region.
+            VkDescriptorBufferInfo descriptorBufferInfo = {};
+            descriptorBufferInfo.buffer = this->vkState->uniformRingBuffer;
+            descriptorBufferInfo.offset = 0;
+            descriptorBufferInfo.range = sizeof(xr::CameraUniformBufferObject);
+
+            VkWriteDescriptorSet uniformBudderDescriptorWrite = {};
+            uniformBudderDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            uniformBudderDescriptorWrite.pNext = nullptr;
+            uniformBudderDescriptorWrite.dstSet = this->vkState->uniformDescriptorSet;
+            uniformBudderDescriptorWrite.dstBinding = 0;
+            uniformBudderDescriptorWrite.dstArrayElement = 0;
+            uniformBudderDescriptorWrite.descriptorCount = 1;
+            uniformBudderDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            uniformBudderDescriptorWrite.pImageInfo = nullptr;
+            uniformBudderDescriptorWrite.pBufferInfo = &descriptorBufferInfo;
+            uniformBudderDescriptorWrite.pTexelBufferView = nullptr;
+
+            vkUpdateDescriptorSets(this->vkState->device, 1, &uniformBudderDescriptorWrite, 0, nullptr);
+        }
+
+        // Instances are drawn with the set of their mesh source.
+        for (size_t index = 0; index < models.size(); ++index)
+        {
+            if (models[index]->instanceSource == nullptr)
+            {
+                initTextureDescriptorSet(models[index]);
+            }
+        }
+    }
+
+    XR_API void Renderer::initTextureDescriptorSet(Model *model)
+    {
+        // Allocating past maxSets is invalid in Vulkan 1.0 rather than a reported error, so the count is tracked here.
+        if (this->vkState->textureDescriptorPoolUsedCount >= this->vkState->textureDescriptorPoolCapacity)
+        {
+            growTextureDescriptorPool();
+        }
+
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetAllocateInfo.pNext = nullptr;
+        descriptorSetAllocateInfo.descriptorPool = this->vkState->textureDescriptorPools.empty()
+                                                     ? this->vkState->descriptorPool
+                                                     : this->vkState->textureDescriptorPools.back();
+        descriptorSetAllocateInfo.descriptorSetCount = 1;
+        descriptorSetAllocateInfo.pSetLayouts = &(this->vkState->textureDescriptorSetLayout);
+
+        VkResult result = vkAllocateDescriptorSets(this->vkState->device, &descriptorSetAllocateInfo, &(model->textureDescriptorSet));
+        CHECK_ERROR(result);
+
+        ++this->vkState->textureDescriptorPoolUsedCount;
+
+        VkDescriptorImageInfo descriptorImageInfo = {};
+        descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        descriptorImageInfo.imageView = model->textureImageView;
+        descriptorImageInfo.sampler = model->textureSampler;
+
+        VkWriteDescriptorSet textureImageDescriptorWrite = {};
+        textureImageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        textureImageDescriptorWrite.pNext = nullptr;
+        textureImageDescriptorWrite.dstSet = model->textureDescriptorSet;
+        textureImageDescriptorWrite.dstBinding = 0;
+        textureImageDescriptorWrite.dstArrayElement = 0;
+        textureImageDescriptorWrite.descriptorCount = 1;
+        textureImageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        textureImageDescriptorWrite.pImageInfo = &descriptorImageInfo;
+        textureImageDescriptorWrite.pBufferInfo = nullptr;
+        textureImageDescriptorWrite.pTexelBufferView = nullptr;
+
+        vkUpdateDescriptorSets(this->vkState->device, 1, &textureImageDescriptorWrite, 0, nullptr);
+    }
+
+    XR_API void Renderer::destroyDescriptorSets(std::vector<Model *> models)
+    {
+        // If you want to explicitly destroy the descriptorSet, then set
+        // poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+        // bit in VkDescriptorPoolCreateInfo else you will get runtime error
+        // while destroying the descriptorSet.
+        // We are not going to used this for now, the sets are released with the pool.
+        this->vkState->uniformDescriptorSet = VK_NULL_HANDLE;
+
+        for (size_t index = 0; index < models.size(); ++index)
+        {
+            models[index]->textureDescriptorSet = VK_NULL_HANDLE;
+        }
+    }
+
+    XR_API void Renderer::initCommandBuffers()
+    {
+        // Every frame in flight owns a pool with one command buffer per swapchain image. The pool is reset
+        // as a whole instead of resetting or freeing buffers one by one, so it does not need
+        // VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT.
+        uint32_t frameCount = this->vkState->MAX_FRAMES_IN_FLIGHT;
+        uint32_t imageCount = this->vkState->swapchainImageCount;
+
+        this->vkState->frameCommandPools.resize(frameCount);
+        this->vkState->commandBuffers.resize(frameCount * imageCount);
+        this->vkState->frameRecordings.assign(frameCount, FrameRecording());
+
+        for (uint32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        {
+            VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+            commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            commandPoolCreateInfo.pNext = nullptr;
+            commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            commandPoolCreateInfo.queueFamilyIndex = this->vkState->queueFamilyIndices.graphicsFamilyIndex;
+
+            VkResult result = vkCreateCommandPool(this->vkState->device, &commandPoolCreateInfo, nullptr, &(this->vkState->frameCommandPools[frameIndex]));
+            CHECK_ERROR(result);
+
+            VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+            commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            commandBufferAllocateInfo.pNext = nullptr;
+            commandBufferAllocateInfo.commandPool = this->vkState->frameCommandPools[frameIndex];
+            commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            commandBufferAllocateInfo.commandBufferCount = imageCount;
+
+            result = vkAllocateCommandBuffers(this->vkState->device, &commandBufferAllocateInfo, &(this->vkState->commandBuffers[frameIndex * imageCount]));
+            CHECK_ERROR(result);
+
+            this->vkState->frameRecordings[frameIndex].isImageRecorded.assign(imageCount, false);
+        }
+
+        // Secondary buffers only inherit the render pass, not the framebuffer, so one set per frame serves every image.
+        uint32_t workerCount = this->vkState->recordingWorkerPool->getWorkerCount();
+
+        this->vkState->secondaryCommandPools.resize(frameCount * workerCount);
+        this->vkState->secondaryCommandBuffers.resize(frameCount * workerCount);
+
+        for (size_t poolIndex = 0; poolIndex < this->vkState->secondaryCommandPools.size(); ++poolIndex)
+        {
+            VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+            commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            commandPoolCreateInfo.pNext = nullptr;
+            commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            commandPoolCreateInfo.queueFamilyIndex = this->vkState->queueFamilyIndices.graphicsFamilyIndex;
+
+            VkResult result = vkCreateCommandPool(this->vkState->device, &commandPoolCreateInfo, nullptr, &(this->vkState->secondaryCommandPools[poolIndex]));
+            CHECK_ERROR(result);
+
+            VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+            commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            commandBufferAllocateInfo.pNext = nullptr;
+            commandBufferAllocateInfo.commandPool = this->vkState->secondaryCommandPools[poolIndex];
+            commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            commandBufferAllocateInfo.commandBufferCount = 1;
+
+            result = vkAllocateCommandBuffers(this->vkState->device, &commandBufferAllocateInfo, &(this->vkState->secondaryCommandBuffers[poolIndex]));
+            CHECK_ERROR(result);
+        }
+    }
+
+    void Renderer::buildDrawCommands(const std::vector<Model *> &models, size_t frameIndex, std::vector<DrawCommand> *drawCommands)
+    {
+        // Pixels covered by one world unit at distance one, used to project LOD errors to the screen.
+        glm::vec3 cameraPosition = glm::vec3(glm::inverse(this->vkState->camera.view)[3]);
+        float projectionScale = std::abs(this->vkState->camera.projection[1][1]) * this->vkState->swapchainExtent.height * 0.5f;
+
+        for (Model *model : models)
+        {
+            model->currentLod = this->selectLod(model, cameraPosition, projectionScale);
+        }
+
+        // Models drawn with the same mesh at the same LOD become one instanced draw, their transforms consecutive.
+        std::vector<uint32_t> &order = this->vkState->instanceOrder;
+        order.resize(models.size());
+
+        for (uint32_t index = 0; index < order.size(); ++index)
+        {
+            order[index] = index;
+        }
+
+        std::sort(order.begin(), order.end(), [&models](uint32_t left, uint32_t right) {
+            const Model *a = models[left];
+            const Model *b = models[right];
+
+            if (a->getMeshSource() != b->getMeshSource())
+            {
+                return std::less<const Model *>()(a->getMeshSource(), b->getMeshSource());
+            }
+
+            return (a->currentLod != b->currentLod) ? a->currentLod < b->currentLod : left < right;
+        });
+
+        InstanceData *instances = static_cast<InstanceData *>(this->vkState->instanceBufferAllocations[frameIndex].mappedData);
+        const Model *batchMesh = nullptr;
+        uint32_t batchLod = 0;
+
+        drawCommands->clear();
+
+        for (uint32_t instanceIndex = 0; instanceIndex < order.size(); ++instanceIndex)
+        {
+            const Model *model = models[order[instanceIndex]];
+            const Model *mesh = model->getMeshSource();
+
+            instances[instanceIndex].modelMatrix = model->modelMatrix * mesh->positionDequantization;
+
+            if (mesh == batchMesh && model->currentLod == batchLod)
+            {
+                ++drawCommands->back().instanceCount;
+                continue;
+            }
+
+            DrawCommand drawCommand = {};
+            drawCommand.pushConstants.textureCoordinateTransform = mesh->textureCoordinateTransform;
+            drawCommand.textureDescriptorSet = mesh->textureDescriptorSet;
+            drawCommand.indexType = mesh->indexType;
+            drawCommand.indexCount = mesh->indexCount;
+            drawCommand.firstIndex = mesh->firstIndex;
+            drawCommand.vertexOffset = mesh->vertexOffset;
+            drawCommand.instanceCount = 1;
+            drawCommand.firstInstance = instanceIndex;
+
+            if (!mesh->lods.empty())
+            {
+                drawCommand.indexCount = mesh->lods[model->currentLod].indexCount;
+                drawCommand.firstIndex += mesh->lods[model->currentLod].firstIndex;
+            }
+
+            drawCommands->push_back(drawCommand);
+            batchMesh = mesh;
+            batchLod = model->currentLod;
+        }
+    }
+
+    void Renderer::growGpuCullingBuffers(size_t frameIndex, uint32_t objectCount)
+    {
+        GpuCullingFrame &cullingFrame = this->vkState->gpuCullingFrames[frameIndex];
+        uint32_t capacity = std::max(cullingFrame.objectCapacity, GPU_CULLING_MIN_OBJECT_CAPACITY);
+
+        while (capacity < objectCount)
+        {
+            capacity *= 2;
+        }
+
+        // Only this frame's buffers and descriptor set are replaced, its fence has signaled so no submitted work uses them.
+        // The other frames grow their own when they come around, without waiting for the device.
+        destroyBuffer(&(cullingFrame.objectBuffer), &(cullingFrame.objectBufferAllocation));
+        destroyBuffer(&(cullingFrame.drawCommandBuffer), &(cullingFrame.drawCommandBufferAllocation));
+        destroyBuffer(&(cullingFrame.drawCountBuffer), &(cullingFrame.drawCountBufferAllocation));
+
+        VkMemoryPropertyFlags hostMemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        createBuffer(
+            capacity * sizeof(xr::GpuObject),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            hostMemoryProperties,
+            &(cullingFrame.objectBuffer),
+            &(cullingFrame.objectBufferAllocation)
+        );
+        createBuffer(
+            capacity * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &(cullingFrame.drawCommandBuffer),
+            &(cullingFrame.drawCommandBufferAllocation)
+        );
+
+        // There are never more draw groups than objects.
+        createBuffer(
+            (capacity + 1) * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            hostMemoryProperties,
+            &(cullingFrame.drawCountBuffer),
+            &(cullingFrame.drawCountBufferAllocation)
+        );
+
+        cullingFrame.objectCapacity = capacity;
+        cullingFrame.objectOrderVersion = 0;
+
+        std::array<VkDescriptorBufferInfo, 3> descriptorBufferInfos = {};
+        descriptorBufferInfos[0].buffer = cullingFrame.objectBuffer;
+        descriptorBufferInfos[1].buffer = cullingFrame.drawCommandBuffer;
+        descriptorBufferInfos[2].buffer = cullingFrame.drawCountBuffer;
+
+        std::array<VkWriteDescriptorSet, 3> descriptorWrites = {};
+
+        for (uint32_t binding = 0; binding < descriptorWrites.size(); ++binding)
+        {
+            descriptorBufferInfos[binding].offset = 0;
+            descriptorBufferInfos[binding].range = VK_WHOLE_SIZE;
+
+            descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[binding].pNext = nullptr;
+            descriptorWrites[binding].dstSet = cullingFrame.descriptorSet;
+            descriptorWrites[binding].dstBinding = binding;
+            descriptorWrites[binding].dstArrayElement = 0;
+            descriptorWrites[binding].descriptorCount = 1;
+            descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[binding].pImageInfo = nullptr;
+            descriptorWrites[binding].pBufferInfo = &(descriptorBufferInfos[binding]);
+            descriptorWrites[binding].pTexelBufferView = nullptr;
+        }
+
+        vkUpdateDescriptorSets(this->vkState->device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+        // The frame's recording referenced the destroyed buffers.
+        if (frameIndex < this->vkState->frameRecordings.size())
+        {
+            this->vkState->frameRecordings[frameIndex].gpuObjectBuffer = VK_NULL_HANDLE;
+        }
+
+        logf("---------- GPU culling capacity [frame %zu, %u objects] ----------", frameIndex, capacity);
+    }
+
+    void Renderer::destroyGpuCullingBuffers()
+    {
+        for (GpuCullingFrame &cullingFrame : this->vkState->gpuCullingFrames)
+        {
+            destroyBuffer(&(cullingFrame.objectBuffer), &(cullingFrame.objectBufferAllocation));
+            destroyBuffer(&(cullingFrame.drawCommandBuffer), &(cullingFrame.drawCommandBufferAllocation));
+            destroyBuffer(&(cullingFrame.drawCountBuffer), &(cullingFrame.drawCountBufferAllocation));
+            cullingFrame.objectCapacity = 0;
+            cullingFrame.objectTransforms.clear();
+        }
+    }
+
+    void Renderer::updateGpuObjectOrder(const std::vector<Model *> &models)
+    {
+        // Regrouping sorts every object, so it only happens when the models or their textures changed.
+        bool isOrderValid = (models.size() == this->vkState->gpuSourceModels.size());
+
+        for (size_t index = 0; index < models.size() && isOrderValid; ++index)
+        {
+            isOrderValid = models[index] == this->vkState->gpuSourceModels[index]
+                        && models[index]->getMeshSource()->textureDescriptorSet == this->vkState->gpuSourceTextureSets[index];
+        }
+
+        if (isOrderValid)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> &order = this->vkState->gpuObjectOrder;
+        std::vector<IndirectDrawGroup> &groups = this->vkState->indirectDrawGroups;
+
+        order.resize(models.size());
+
+        for (uint32_t index = 0; index < order.size(); ++index)
+        {
+            order[index] = index;
+        }
+
+        // Objects sharing a texture and index type become one contiguous range of command slots, drawn together.
+        std::stable_sort(order.begin(), order.end(), [&models](uint32_t left, uint32_t right) {
+            const Model *a = models[left]->getMeshSource();
+            const Model *b = models[right]->getMeshSource();
+            return (a->textureDescriptorSet != b->textureDescriptorSet)
+                ? std::less<VkDescriptorSet>()(a->textureDescriptorSet, b->textureDescriptorSet)
+                : a->indexType < b->indexType;
+        });
+
+        groups.clear();
+        this->vkState->gpuObjectGroups.resize(order.size());
+
+        for (uint32_t slot = 0; slot < order.size(); ++slot)
+        {
+            const Model *model = models[order[slot]]->getMeshSource();
+
+            if (groups.empty() || groups.back().textureDescriptorSet != model->textureDescriptorSet || groups.back().indexType != model->indexType)
+            {
+                IndirectDrawGroup group = {};
+                group.textureDescriptorSet = model->textureDescriptorSet;
+                group.indexType = model->indexType;
+                group.firstCommand = slot;
+                groups.push_back(group);
+            }
+
+            ++groups.back().commandCount;
+            this->vkState->gpuObjectGroups[slot] = static_cast<uint32_t>(groups.size() - 1);
+        }
+
+        this->vkState->gpuSourceModels = models;
+        this->vkState->gpuSourceTextureSets.resize(models.size());
+
+        for (size_t index = 0; index < models.size(); ++index)
+        {
+            this->vkState->gpuSourceTextureSets[index] = models[index]->getMeshSource()->textureDescriptorSet;
+        }
+
+        ++this->vkState->gpuObjectOrderVersion;
+    }
+
+    void Renderer::writeGpuObjects(const std::vector<Model *> &models, size_t frameIndex)
+    {
+        GpuCullingFrame &cullingFrame = this->vkState->gpuCullingFrames[frameIndex];
+        GpuObject *objects = static_cast<GpuObject *>(cullingFrame.objectBufferAllocation.mappedData);
+        const std::vector<uint32_t> &order = this->vkState->gpuObjectOrder;
+
+        std::vector<glm::mat4> &transforms = cullingFrame.objectTransforms;
+
+        // Between regroups only the transforms move, the rest of each object stays in the frame's buffer. Host visible
+        // memory is often uncached, so only objects that moved since this frame last wrote them are touched.
+        if (cullingFrame.objectOrderVersion == this->vkState->gpuObjectOrderVersion)
+        {
+            for (size_t slot = 0; slot < order.size(); ++slot)
+            {
+                const glm::mat4 &modelMatrix = models[order[slot]]->modelMatrix;
+
+                if (modelMatrix != transforms[slot])
+                {
+                    objects[slot].modelMatrix = modelMatrix;
+                    transforms[slot] = modelMatrix;
+                }
+            }
+
+            return;
+        }
+
+        transforms.resize(order.size());
+
+        for (uint32_t slot = 0; slot < order.size(); ++slot)
+        {
+            const Model *model = models[order[slot]];
+            const Model *mesh = model->getMeshSource();
+            uint32_t groupIndex = this->vkState->gpuObjectGroups[slot];
+
+            GpuObject object = {};
+            object.modelMatrix = model->modelMatrix;
+            object.positionScale = glm::vec4(
+                mesh->positionDequantization[0][0], mesh->positionDequantization[1][1], mesh->positionDequantization[2][2], 0.0f
+            );
+            object.positionOffset = glm::vec4(glm::vec3(mesh->positionDequantization[3]), 0.0f);
+            object.textureCoordinateTransform = mesh->textureCoordinateTransform;
+            object.boundingSphere = glm::vec4(mesh->boundingSphereCenter, mesh->boundingSphereRadius);
+            object.drawRange = glm::uvec4(
+                static_cast<uint32_t>(mesh->vertexOffset), slot, groupIndex, this->vkState->indirectDrawGroups[groupIndex].firstCommand
+            );
+
+            if (mesh->lods.empty())
+            {
+                object.lodFirstIndex[0] = mesh->firstIndex;
+                object.lodIndexCount[0] = mesh->indexCount;
+            }
+
+            // The shader picks a level the same way selectLod() does, from the first four levels.
+            for (size_t level = 0; level < std::min<size_t>(mesh->lods.size(), 4); ++level)
+            {
+                object.lodFirstIndex[level] = mesh->firstIndex + mesh->lods[level].firstIndex;
+                object.lodIndexCount[level] = mesh->lods[level].indexCount;
+                object.lodError[level] = mesh->lods[level].error;
+            }
+
+            objects[slot] = object;
+            transforms[slot] = model->modelMatrix;
+        }
+
+        cullingFrame.objectOrderVersion = this->vkState->gpuObjectOrderVersion;
+    }
+
+    void Renderer::readGpuCullingStatistics(size_t frameIndex)
+    {
+        const FrameRecording &frameRecording = this->vkState->frameRecordings[frameIndex];
+        const GpuCullingFrame &cullingFrame = this->vkState->gpuCullingFrames[frameIndex];
+
+        // The counts are only meaningful once a recording using these buffers was submitted, its fence has signalled.
+        if (frameRecording.gpuObjectBuffer != cullingFrame.objectBuffer || frameRecording.indirectDrawGroups.empty())
+        {
+            return;
+        }
+
+        const IndirectDrawGroup &lastGroup = frameRecording.indirectDrawGroups.back();
+        const uint32_t *drawCounts = static_cast<const uint32_t *>(cullingFrame.drawCountBufferAllocation.mappedData);
+
+        CullingStatistics &statistics = this->vkState->gpuCullingStatistics;
+        statistics.testedCount = lastGroup.firstCommand + lastGroup.commandCount;
+        statistics.visibleCount = drawCounts[0];
+        statistics.culledCount = statistics.testedCount - statistics.visibleCount;
+    }
+
+    void Renderer::recordGpuCulling(VkCommandBuffer commandBuffer, size_t frameIndex)
+    {
+        const GpuCullingFrame &cullingFrame = this->vkState->gpuCullingFrames[frameIndex];
+        const FrameRecording &frameRecording = this->vkState->frameRecordings[frameIndex];
+
+        // The culling pass accumulates into the counts, they start from zero every frame.
+        vkCmdFillBuffer(commandBuffer, cullingFrame.drawCountBuffer, 0, VK_WHOLE_SIZE, 0);
+
+        VkMemoryBarrier fillBarrier = {};
+        fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        fillBarrier.pNext = nullptr;
+        fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+
+        GpuCullingPushConstants pushConstants = {};
+        pushConstants.isCompacting = (this->vkState->cmdDrawIndexedIndirectCount != nullptr) ? 1 : 0;
+
+        if (!frameRecording.indirectDrawGroups.empty())
+        {
+            pushConstants.objectCount = frameRecording.indirectDrawGroups.back().firstCommand + frameRecording.indirectDrawGroups.back().commandCount;
+        }
+
+        if (pushConstants.objectCount > 0)
+        {
+            std::array<VkDescriptorSet, 2> descriptorSets = { this->vkState->uniformDescriptorSet, cullingFrame.descriptorSet };
+            uint32_t dynamicOffset = static_cast<uint32_t>(frameIndex * this->vkState->uniformFrameSize);
+
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->vkState->cullPipeline);
+            vkCmdBindDescriptorSets(
+                commandBuffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                this->vkState->cullPipelineLayout,
+                0,
+                static_cast<uint32_t>(descriptorSets.size()),
+                descriptorSets.data(),
+                1,
+                &dynamicOffset
+            );
+            vkCmdPushConstants(
+                commandBuffer, this->vkState->cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(xr::GpuCullingPushConstants), &pushConstants
+            );
+            vkCmdDispatch(commandBuffer, (pushConstants.objectCount + GPU_CULLING_WORKGROUP_SIZE - 1) / GPU_CULLING_WORKGROUP_SIZE, 1, 1);
+        }
+
+        // The draws consume the commands and counts, the host reads the visible total back once the frame's fence signalled.
+        VkMemoryBarrier cullBarrier = {};
+        cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullBarrier.pNext = nullptr;
+        cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            1,
+            &cullBarrier,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+    }
+
+    void Renderer::recordIndirectDraws(VkCommandBuffer commandBuffer, size_t frameIndex)
+    {
+        const GpuCullingFrame &cullingFrame = this->vkState->gpuCullingFrames[frameIndex];
+        const FrameRecording &frameRecording = this->vkState->frameRecordings[frameIndex];
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->indirectPipeline);
+        setViewportAndScissor(commandBuffer);
+
+        uint32_t dynamicOffset = static_cast<uint32_t>(frameIndex * this->vkState->uniformFrameSize);
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->indirectPipelineLayout, 0, 1, &(this->vkState->uniformDescriptorSet), 1, &dynamicOffset
+        );
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->indirectPipelineLayout, 2, 1, &(cullingFrame.descriptorSet), 0, nullptr
+        );
+
+        VkDeviceSize offset = { 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &(this->vkState->vertexGeometryBuffer.buffer), &offset);
+
+        // Recording cost scales with the number of textures, not objects.
+        VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+        uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        uint32_t maxDrawCount = this->vkState->gpuDetails.properties.limits.maxDrawIndirectCount;
+
+        for (size_t groupIndex = 0; groupIndex < frameRecording.indirectDrawGroups.size(); ++groupIndex)
+        {
+            const IndirectDrawGroup &group = frameRecording.indirectDrawGroups[groupIndex];
+            VkDeviceSize commandOffset = group.firstCommand * static_cast<VkDeviceSize>(stride);
+
+            if (group.indexType != boundIndexType)
+            {
+                vkCmdBindIndexBuffer(commandBuffer, this->vkState->indexGeometryBuffer.buffer, 0, group.indexType);
+                boundIndexType = group.indexType;
+            }
+
+            vkCmdBindDescriptorSets(
+                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->indirectPipelineLayout, 1, 1, &(group.textureDescriptorSet), 0, nullptr
+            );
+
+            if (this->vkState->cmdDrawIndexedIndirectCount != nullptr)
+            {
+                // Only the visible draws the culling pass appended behind firstCommand are executed.
+                VkDeviceSize countOffset = (groupIndex + 1) * sizeof(uint32_t);
+                this->vkState->cmdDrawIndexedIndirectCount(
+                    commandBuffer,
+                    cullingFrame.drawCommandBuffer,
+                    commandOffset,
+                    cullingFrame.drawCountBuffer,
+                    countOffset,
+                    std::min(group.commandCount, maxDrawCount),
+                    stride
+                );
+                continue;
+            }
+
+            // Every object keeps its slot, culled ones are skipped by the GPU with an instanceCount of 0.
+            uint32_t first = 0;
+
+            while (first < group.commandCount)
+            {
+                uint32_t drawCount = std::min(group.commandCount - first, maxDrawCount);
+                vkCmdDrawIndexedIndirect(commandBuffer, cullingFrame.drawCommandBuffer, commandOffset + first * static_cast<VkDeviceSize>(stride), drawCount, stride);
+                first += drawCount;
+            }
+        }
+    }
+
+    void Renderer::resetFrameCommandPools(size_t frameIndex)
+    {
+        // The frame's fence covers every earlier submission from these pools, so none of their buffers is pending.
+        VkResult result = vkResetCommandPool(this->vkState->device, this->vkState->frameCommandPools[frameIndex], 0);
+        CHECK_ERROR(result);
+
+        uint32_t workerCount = this->vkState->recordingWorkerPool->getWorkerCount();
+
+        for (uint32_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+        {
+            result = vkResetCommandPool(this->vkState->device, this->vkState->secondaryCommandPools[frameIndex * workerCount + workerIndex], 0);
+            CHECK_ERROR(result);
+        }
+    }
+
+    uint32_t Renderer::recordSecondaryCommandBuffers(size_t frameIndex, const std::vector<DrawCommand> &drawCommands, uint32_t workerCount)
+    {
+        uint32_t poolWorkerCount = this->vkState->recordingWorkerPool->getWorkerCount();
+        size_t usefulWorkerCount = (drawCommands.size() + MIN_DRAWS_PER_RECORDING_WORKER - 1) / MIN_DRAWS_PER_RECORDING_WORKER;
+
+        workerCount = std::min(workerCount, poolWorkerCount);
+        workerCount = static_cast<uint32_t>(std::max<size_t>(std::min<size_t>(workerCount, usefulWorkerCount), 1));
+
+        // Contiguous slices keep the draw order when the secondary buffers are executed in worker order.
+        size_t sliceSize = (drawCommands.size() + workerCount - 1) / workerCount;
+        VkCommandBuffer *commandBuffers = &(this->vkState->secondaryCommandBuffers[frameIndex * poolWorkerCount]);
+
+        this->vkState->recordingWorkerPool->run(workerCount, [&](uint32_t workerIndex) {
+            size_t first = std::min(workerIndex * sliceSize, drawCommands.size());
+            size_t last = std::min(first + sliceSize, drawCommands.size());
+
+            recordDrawCommands(commandBuffers[workerIndex], frameIndex, drawCommands.data() + first, last - first);
+        });
+
+        return workerCount;
+    }
+
+    void Renderer::recordDrawCommands(VkCommandBuffer commandBuffer, size_t frameIndex, const DrawCommand *drawCommands, size_t drawCount)
+    {
+        VkCommandBufferInheritanceInfo commandBufferInheritanceInfo = {};
+        commandBufferInheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        commandBufferInheritanceInfo.pNext = nullptr;
+        commandBufferInheritanceInfo.renderPass = this->vkState->renderPass;
+        commandBufferInheritanceInfo.subpass = 0;
+        commandBufferInheritanceInfo.framebuffer = VK_NULL_HANDLE;
+        commandBufferInheritanceInfo.occlusionQueryEnable = VK_FALSE;
+        commandBufferInheritanceInfo.queryFlags = 0;
+        commandBufferInheritanceInfo.pipelineStatistics = 0;
+
+        // Simultaneous use, the primary buffers of every swapchain image execute the same secondary buffers.
+        VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        commandBufferBeginInfo.pNext = nullptr;
+        commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        commandBufferBeginInfo.pInheritanceInfo = &commandBufferInheritanceInfo;
+
+        VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+        CHECK_ERROR(result);
+
+        // Secondary buffers start without any state, every one binds the pipeline and shared resources itself.
+        // Dynamic state is not inherited either, so each sets the viewport of the extent it was recorded for.
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->pipeline);
+        setViewportAndScissor(commandBuffer);
+
+        // The camera block of this frame is the same for every draw, bind it once.
+        uint32_t dynamicOffset = static_cast<uint32_t>(frameIndex * this->vkState->uniformFrameSize);
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->pipelineLayout, 0, 1, &(this->vkState->uniformDescriptorSet), 1, &dynamicOffset
+        );
+
+        // All models share the geometry buffers, so they are bound once and each draw selects its ranges by offset.
+        // Binding 1 streams the per instance transforms of this frame, each draw selects its range by firstInstance.
+        VkBuffer vertexBuffers[] = { this->vkState->vertexGeometryBuffer.buffer, this->vkState->instanceBuffers[frameIndex] };
+        VkDeviceSize offsets[] = { 0, 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+
+        // The index buffer is only re-bound when the index type changes between models.
+        VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+        for (size_t index = 0; index < drawCount; ++index)
+        {
+            const DrawCommand &drawCommand = drawCommands[index];
+
+            if (drawCommand.indexType != boundIndexType)
+            {
+                vkCmdBindIndexBuffer(commandBuffer, this->vkState->indexGeometryBuffer.buffer, 0, drawCommand.indexType);
+                boundIndexType = drawCommand.indexType;
+            }
+
+            vkCmdBindDescriptorSets(
+                commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkState->pipelineLayout, 1, 1, &(drawCommand.textureDescriptorSet), 0, nullptr
+            );
+            vkCmdPushConstants(
+                commandBuffer, this->vkState->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(xr::ObjectPushConstants), &(drawCommand.pushConstants)
+            );
+
+            vkCmdDrawIndexed(
+                commandBuffer, drawCommand.indexCount, drawCommand.instanceCount, drawCommand.firstIndex, drawCommand.vertexOffset, drawCommand.firstInstance
+            );
+        }
+
+        result = vkEndCommandBuffer(commandBuffer);
+        CHECK_ERROR(result);
+    }
+
+    void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t frameIndex)
+    {
+        // No VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, the buffer is submitted again while its frame's draws do not change.
+        VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        commandBufferBeginInfo.pNext = nullptr;
+        commandBufferBeginInfo.flags = 0;
+        commandBufferBeginInfo.pInheritanceInfo = nullptr;
+
+        // The buffer has to be in the initial state: render() only records an image whose flag was cleared together with
+        // a reset of the frame's pools, recreateSwapChain() invalidates recordings the same way.
+        VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+        CHECK_ERROR(result);
+
+        VkRect2D renderArea = {};
+        renderArea.offset.x = 0;
+        renderArea.offset.y = 0;
+        renderArea.extent.width = this->vkState->swapchainExtent.width;
+        renderArea.extent.height = this->vkState->swapchainExtent.height;
+
+        std::array<VkClearValue, 2> clearValue = {};
+        clearValue[0].color = { 0.0f, 0.0f, 0.0f, 1.0f }; // {r, g, b, a}
+        clearValue[1].depthStencil = { 1.0f, 0 };         // {depth, stencil}
+
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.pNext = nullptr;
+        renderPassBeginInfo.renderPass = this->vkState->renderPass;
+        renderPassBeginInfo.framebuffer = this->vkState->framebuffers[imageIndex];
+        renderPassBeginInfo.renderArea = renderArea;
+        renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValue.size());
+        renderPassBeginInfo.pClearValues = clearValue.data();
+
+        if (this->vkState->isGpuDrivenRenderingEnabled)
+        {
+            // The culling pass has to run outside the render pass, the few indirect draws are recorded inline.
+            recordGpuCulling(commandBuffer, frameIndex);
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            recordIndirectDraws(commandBuffer, frameIndex);
+            vkCmdEndRenderPass(commandBuffer);
+        }
+        else
+        {
+            // The draws themselves live in the frame's secondary command buffers, executed in recording order.
+            uint32_t workerCount = this->vkState->recordingWorkerPool->getWorkerCount();
+            const FrameRecording &frameRecording = this->vkState->frameRecordings[frameIndex];
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdExecuteCommands(commandBuffer, frameRecording.secondaryCommandBufferCount, &(this->vkState->secondaryCommandBuffers[frameIndex * workerCount]));
+            vkCmdEndRenderPass(commandBuffer);
+        }
+
+        result = vkEndCommandBuffer(commandBuffer);
+        CHECK_ERROR(result);
+    }
+
+#if ENABLE_COMMAND_RECORDING_BENCHMARK
+    void Renderer::benchmarkCommandRecording(size_t frameIndex, const std::vector<DrawCommand> &drawCommands)
+    {
+        if (drawCommands.empty())
+        {
+            return;
+        }
+
+        // The scene's draws repeated up to a list large enough for threading to matter, recorded but never submitted.
+        const size_t benchmarkDrawCount = 32768;
+        const uint32_t repeatCount = 5;
+        std::vector<DrawCommand> benchmarkDrawCommands(benchmarkDrawCount);
+
+        for (size_t index = 0; index < benchmarkDrawCount; ++index)
+        {
+            benchmarkDrawCommands[index] = drawCommands[index % drawCommands.size()];
+        }
+
+        logf("---------- Command recording benchmark, %zu draws ----------", benchmarkDrawCount);
+
+        float singleWorkerTime = 0.0f;
+
+        for (uint32_t workerCount = 1; workerCount <= this->vkState->recordingWorkerPool->getWorkerCount(); ++workerCount)
+        {
+            float bestTime = FLT_MAX;
+
+            for (uint32_t repeat = 0; repeat < repeatCount; ++repeat)
+            {
+                resetFrameCommandPools(frameIndex);
+
+                auto startTime = std::chrono::high_resolution_clock::now();
+                recordSecondaryCommandBuffers(frameIndex, benchmarkDrawCommands, workerCount);
+                auto endTime = std::chrono::high_resolution_clock::now();
+
+                bestTime = std::min(bestTime, std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count());
+            }
+
+            singleWorkerTime = (workerCount == 1) ? bestTime : singleWorkerTime;
+            logf("%d workers\t: %f ms, %fx", workerCount, bestTime, singleWorkerTime / bestTime);
+        }
+
+        // Leave the pools as if nothing had been recorded, the caller records the real frame next.
+        resetFrameCommandPools(frameIndex);
+    }
+#endif
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+    void Renderer::benchmarkFramePipelining(float fenceWaitTime)
+    {
+        FramePipeliningBenchmark &benchmark = this->vkState->framePipeliningBenchmark;
+        auto currentTime = std::chrono::high_resolution_clock::now();
+
+        // The first frame of a run only starts the clock, the switch between modes is not measured.
+        if (benchmark.frameCount > 0)
+        {
+            benchmark.frameTime += std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - benchmark.lastFrameTime).count();
+            benchmark.fenceWaitTime += fenceWaitTime;
+        }
+
+        benchmark.lastFrameTime = currentTime;
+
+        if (benchmark.frameCount++ < FRAME_PIPELINING_BENCHMARK_FRAMES)
+        {
+            return;
+        }
+
+        float frameTime = benchmark.frameTime / FRAME_PIPELINING_BENCHMARK_FRAMES;
+        float fenceWaitTimePerFrame = benchmark.fenceWaitTime / FRAME_PIPELINING_BENCHMARK_FRAMES;
+
+        if (benchmark.isSerialized)
+        {
+            benchmark.serializedFrameTime = frameTime;
+        }
+        else
+        {
+            // A pipelined frame only blocks on its fences when the GPU is behind, otherwise the CPU sets the pace.
+            bool isGpuBound = fenceWaitTimePerFrame > frameTime * 0.25f;
+
+            logf("---------- Frame pipelining benchmark (%s bound) ----------", isGpuBound ? "GPU" : "CPU");
+            logf("Serialized\t: %f ms", benchmark.serializedFrameTime);
+            logf("Pipelined\t: %f ms, %fx, fence wait %f ms", frameTime, benchmark.serializedFrameTime / frameTime, fenceWaitTimePerFrame);
+        }
+
+        benchmark.isSerialized = !benchmark.isSerialized;
+        benchmark.frameCount = 0;
+        benchmark.frameTime = 0.0f;
+        benchmark.fenceWaitTime = 0.0f;
+    }
+#endif
+
+    uint32_t Renderer::selectLod(const Model *model, const glm::vec3 &cameraPosition, float projectionScale) const
+    {
+        const Model *mesh = model->getMeshSource();
+
+        // Bounding sphere in world space, the error grows with the largest axis scale.
+        glm::vec3 center = glm::vec3(model->modelMatrix * glm::vec4(mesh->boundingSphereCenter, 1.0f));
+        float scale = std::max(
+            glm::length(glm::vec3(model->modelMatrix[0])),
+            std::max(glm::length(glm::vec3(model->modelMatrix[1])), glm::length(glm::vec3(model->modelMatrix[2])))
+        );
+        float radius = mesh->boundingSphereRadius * scale;
+        float distance = std::max(glm::length(center - cameraPosition) - radius, 0.0001f);
+
+        // Levels are ordered by increasing error, take the coarsest one that stays below the threshold on screen.
+        uint32_t selectedLod = 0;
+
+        for (uint32_t level = 1; level < mesh->lods.size(); ++level)
+        {
+            float pixelError = mesh->lods[level].error * scale / distance * projectionScale;
+
+            if (pixelError > this->vkState->lodPixelErrorThreshold)
+            {
+                break;
+            }
+
+            selectedLod = level;
+        }
+
+        return selectedLod;
+    }
+
+    XR_API void Renderer::destroyCommandBuffers()
+    {
+        logf("---------- Frame Command Buffers ----------");
+        logf("Recorded\t: %llu", static_cast<unsigned long long>(this->vkState->recordedCommandBufferCount));
+        logf("Reused\t: %llu", static_cast<unsigned long long>(this->vkState->reusedCommandBufferCount));
+
+        // Destroying the pools frees their command buffers.
+        for (VkCommandPool frameCommandPool : this->vkState->frameCommandPools)
+        {
+            vkDestroyCommandPool(this->vkState->device, frameCommandPool, nullptr);
+        }
+
+        for (VkCommandPool secondaryCommandPool : this->vkState->secondaryCommandPools)
+        {
+            vkDestroyCommandPool(this->vkState->device, secondaryCommandPool, nullptr);
+        }
+
+        this->vkState->frameCommandPools.clear();
+        this->vkState->secondaryCommandPools.clear();
+        this->vkState->secondaryCommandBuffers.clear();
+        this->vkState->commandBuffers.clear();
+        this->vkState->frameRecordings.clear();
+    }
+
+    XR_API void Renderer::initSynchronizations()
+    {
+        this->vkState->imageAvailableSemaphores.resize(this->vkState->MAX_FRAMES_IN_FLIGHT);
+        this->vkState->renderFinishedSemaphores.resize(this->vkState->MAX_FRAMES_IN_FLIGHT);
+        this->vkState->inFlightFences.resize(this->vkState->MAX_FRAMES_IN_FLIGHT);
+
+        VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreCreateInfo.pNext = nullptr;
+        semaphoreCreateInfo.flags = 0;
+
+        VkFenceCreateInfo fenceCreateInfo = {};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.pNext = nullptr;
+        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        for (size_t counter = 0; counter < this->vkState->MAX_FRAMES_IN_FLIGHT; ++counter)
+        {
+            VkResult result = vkCreateSemaphore(this->vkState->device, &semaphoreCreateInfo, nullptr, &this->vkState->imageAvailableSemaphores[counter]);
+            CHECK_ERROR(result);
+
+            result = vkCreateSemaphore(this->vkState->device, &semaphoreCreateInfo, nullptr, &this->vkState->renderFinishedSemaphores[counter]);
+            CHECK_ERROR(result);
+
+            result = vkCreateFence(this->vkState->device, &fenceCreateInfo, nullptr, &(this->vkState->inFlightFences[counter]));
+            CHECK_ERROR(result);
+        }
+
+        this->vkState->imagesInFlight.assign(this->vkState->swapchainImageCount, VK_NULL_HANDLE);
+        this->vkState->frameNumbers.assign(this->vkState->MAX_FRAMES_IN_FLIGHT, 0);
+    }
+
+    XR_API void Renderer::destroySynchronizations()
+    {
+        for (size_t counter = 0; counter < this->vkState->MAX_FRAMES_IN_FLIGHT; ++counter)
+        {
+            vkDestroySemaphore(this->vkState->device, this->vkState->imageAvailableSemaphores[counter], nullptr);
+            vkDestroySemaphore(this->vkState->device, this->vkState->renderFinishedSemaphores[counter], nullptr);
+            vkDestroyFence(this->vkState->device, this->vkState->inFlightFences[counter], nullptr);
+        }
+
+        this->vkState->imageAvailableSemaphores.clear();
+        this->vkState->renderFinishedSemaphores.clear();
+        this->vkState->inFlightFences.clear();
+        this->vkState->imagesInFlight.clear();
+        this->vkState->frameNumbers.clear();
+    }
+
+    XR_API void Renderer::recreateSwapChain()
+    {
+        logf("---------- Recreate SwapChain --------");
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        VkFormat oldSurfaceFormat = this->vkState->surfaceFormat.format;
+        VkExtent2D oldSwapchainExtent = this->vkState->swapchainExtent;
+        uint32_t oldSwapchainImageCount = this->vkState->swapchainImageCount;
+
+        // Only what depends on the swapchain images or the surface extent is rebuilt. Descriptors, uniform buffers,
+        // command pools and sync objects do not, so they live on whatever the number of models.
+        cleanupSwapChain();
+        initSwapchain();
+        initSwapchainImageViews();
+
+        bool isFormatChanged = this->vkState->surfaceFormat.format != oldSurfaceFormat;
+        bool isExtentChanged = this->vkState->swapchainExtent.width != oldSwapchainExtent.width
+                            || this->vkState->swapchainExtent.height != oldSwapchainExtent.height;
+
+        // The render pass depends on the color format and the pipelines on the render pass. The viewport is dynamic,
+        // a new extent only needs new command buffers.
+        if (isFormatChanged)
+        {
+            destroyRenderPass();
+            initRenderPass();
+            destroyGraphicsPipline();
+            initGraphicsPipline();
+        }
+
+        initDepthStencilImage();
+        initMSAAColorImage();
+        initFrameBuffers();
+
+        // Primary command buffers exist per swapchain image, they are reallocated when the image count changed.
+        // Otherwise recordings are invalidated: primaries name the old framebuffers, secondaries the old pipeline or viewport.
+        if (this->vkState->swapchainImageCount != oldSwapchainImageCount)
+        {
+            destroyCommandBuffers();
+            initCommandBuffers();
+        }
+        else
+        {
+            // A default recording marks the frame dirty, so render() resets its pools before any buffer is recorded again.
+            for (FrameRecording &frameRecording : this->vkState->frameRecordings)
+            {
+                frameRecording = FrameRecording();
+            }
+        }
+
+        this->vkState->imagesInFlight.assign(this->vkState->swapchainImageCount, VK_NULL_HANDLE);
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        logf(
+            "---------- SwapChain recreated in %f ms, format changed: %d, extent changed: %d ----------",
+            std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count(),
+            isFormatChanged,
+            isExtentChanged
+        );
+    }
+
+    XR_API void Renderer::cleanupSwapChain()
+    {
+        // Frames in flight still render to the old images. The swapchain itself stays until initSwapchain() hands it over.
+        waitForIdle();
+        destroyFrameBuffers();
+        destroyMSAAColorImage();
+        destroyDepthStencilImage();
+        destroySwapchainImageViews();
+    }
+
+    XR_API void Renderer::setFramePacingPolicy(FramePacingPolicy policy, float targetFrameRate)
+    {
+        // Slots that drop out of the cycle must not be left with frames in flight, wait for all of them once.
+        if (!this->vkState->inFlightFences.empty())
+        {
+            VkResult result = vkWaitForFences(
+                this->vkState->device, static_cast<uint32_t>(this->vkState->inFlightFences.size()), this->vkState->inFlightFences.data(), VK_TRUE, UINT64_MAX
+            );
+            CHECK_ERROR(result);
+        }
+
+        for (size_t frameIndex = 0; frameIndex < this->vkState->MAX_FRAMES_IN_FLIGHT; ++frameIndex)
+        {
+            this->vkState->framePacer.onFrameComplete(frameIndex);
+        }
+
+        this->vkState->framePacer.setPolicy(policy, targetFrameRate);
+        this->vkState->framesInFlight = this->vkState->framePacer.getFramesInFlight(this->vkState->MAX_FRAMES_IN_FLIGHT);
+
+        logf(
+            "---------- Frame pacing: %s, %d frames in flight, %f fps target ----------",
+            getFramePacingPolicyName(policy),
+            this->vkState->framesInFlight,
+            targetFrameRate
+        );
+    }
+
+    XR_API void Renderer::beginFrame()
+    {
+        this->vkState->framePacer.waitForFrameStart();
+
+        // Update the current frame count at start as render() might return in between and fail to update the counter
+        this->vkState->currentFrame = (this->vkState->currentFrame + 1) % this->vkState->framesInFlight;
+
+        // A frame's latency ends when its fence is first seen signaled, so the other slots are polled every frame.
+        for (size_t frameIndex = 0; frameIndex < this->vkState->framesInFlight; ++frameIndex)
+        {
+            if (frameIndex != this->vkState->currentFrame && this->vkState->framePacer.isFramePending(frameIndex)
+                && vkGetFenceStatus(this->vkState->device, this->vkState->inFlightFences[frameIndex]) == VK_SUCCESS)
+            {
+                this->vkState->framePacer.onFrameComplete(frameIndex);
+            }
+        }
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+        auto fenceWaitStartTime = std::chrono::high_resolution_clock::now();
+#endif
+
+        // Only the frame that used this slot framesInFlight frames ago has to be finished, the others may still run.
+        // With one frame in flight this is the previous frame, so the application latches input after the GPU is done.
+        VkResult result = vkWaitForFences(this->vkState->device, 1, &(this->vkState->inFlightFences[this->vkState->currentFrame]), VK_TRUE, UINT64_MAX);
         CHECK_ERROR(result);
 
+        this->vkState->framePacer.onFrameComplete(this->vkState->currentFrame);
+        releaseRetiredBuffers(this->vkState->frameNumbers[this->vkState->currentFrame]);
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+        this->vkState->framePipeliningBenchmark.frameFenceWaitTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - fenceWaitStartTime
+        ).count();
+#endif
+
+        this->vkState->isFrameBegun = true;
+    }
+
+    XR_API void Renderer::render(std::vector<Model *> models)
+    {
+        VkResult result = VK_SUCCESS;
+
+        if (!this->vkState->isFrameBegun)
+        {
+            beginFrame();
+        }
+
+        this->vkState->isFrameBegun = false;
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+        float fenceWaitTime = this->vkState->framePipeliningBenchmark.frameFenceWaitTime;
+        auto fenceWaitStartTime = std::chrono::high_resolution_clock::now();
+#endif
+
         uint32_t activeSwapchainImageId = UINT32_MAX;
 
         result = vkAcquireNextImageKHR(
@@ -2024,25 +4002,145 @@ namespace xr
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
             logf("Swapchain out of date before presenting");
-            recreateSwapChain(models);
+            recreateSwapChain();
             return;
         }
-        else if (result == VK_SUBOPTIMAL_KHR)
+        else if (result != VK_SUBOPTIMAL_KHR)
         {
-            logf("Swapchain suboptimal before presenting");
-            recreateSwapChain(models);
-            return;
+            CHECK_ERROR(result);
         }
-        else
+
+        // A suboptimal image was still acquired and its semaphore will signal, the frame is rendered and presented
+        // and the swapchain is recreated once vkQueuePresentKHR reports it again.
+
+        // The acquired image may still be rendered to by another frame in flight, its fence has to signal before the
+        // image's command buffers are re-recorded or its framebuffer is drawn to again.
+        VkFence &imageInFlight = this->vkState->imagesInFlight[activeSwapchainImageId];
+
+        if (imageInFlight != VK_NULL_HANDLE && imageInFlight != this->vkState->inFlightFences[this->vkState->currentFrame])
         {
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+            fenceWaitStartTime = std::chrono::high_resolution_clock::now();
+#endif
+
+            result = vkWaitForFences(this->vkState->device, 1, &imageInFlight, VK_TRUE, UINT64_MAX);
             CHECK_ERROR(result);
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+            fenceWaitTime += std::chrono::duration<float, std::chrono::milliseconds::period>(
+                std::chrono::high_resolution_clock::now() - fenceWaitStartTime
+            ).count();
+#endif
         }
 
+        imageInFlight = this->vkState->inFlightFences[this->vkState->currentFrame];
+
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+        benchmarkFramePipelining(fenceWaitTime);
+#endif
+
         result = vkResetFences(this->vkState->device, 1, &(this->vkState->inFlightFences[this->vkState->currentFrame]));
         CHECK_ERROR(result);
 
-        // Update the uniform buffer for current image.
-        updateUniformBuffer(models, activeSwapchainImageId);
+        // Update the uniform ring buffer region of the current frame, its previous use was fenced above.
+        updateUniformBuffer(this->vkState->currentFrame);
+
+        FrameRecording &frameRecording = this->vkState->frameRecordings[this->vkState->currentFrame];
+        size_t commandBufferIndex = this->vkState->currentFrame * this->vkState->swapchainImageCount + activeSwapchainImageId;
+        VkCommandBuffer commandBuffer = this->vkState->commandBuffers[commandBufferIndex];
+
+        // Geometry buffers are replaced when they grow, so their handles are part of what was recorded.
+        bool isFrameDirty = frameRecording.vertexBuffer != this->vkState->vertexGeometryBuffer.buffer
+                         || frameRecording.indexBuffer != this->vkState->indexGeometryBuffer.buffer;
+
+        if (this->vkState->isGpuDrivenRenderingEnabled)
+        {
+            // Every model goes to the GPU, which culls and picks the LOD. The recording only depends on the draw groups,
+            // so it survives moving objects and the CPU cost per object is a transform compare.
+            readGpuCullingStatistics(this->vkState->currentFrame);
+
+            auto startTime = std::chrono::high_resolution_clock::now();
+
+            if (models.size() > this->vkState->gpuCullingFrames[this->vkState->currentFrame].objectCapacity)
+            {
+                growGpuCullingBuffers(this->vkState->currentFrame, static_cast<uint32_t>(models.size()));
+            }
+
+            updateGpuObjectOrder(models);
+            writeGpuObjects(models, this->vkState->currentFrame);
+
+            auto endTime = std::chrono::high_resolution_clock::now();
+            this->vkState->gpuCullingStatistics.cullTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+
+            GpuCullingFrame &cullingFrame = this->vkState->gpuCullingFrames[this->vkState->currentFrame];
+            isFrameDirty = isFrameDirty
+                        || frameRecording.indirectDrawGroups != this->vkState->indirectDrawGroups
+                        || frameRecording.gpuObjectBuffer != cullingFrame.objectBuffer;
+
+            if (isFrameDirty)
+            {
+                resetFrameCommandPools(this->vkState->currentFrame);
+
+                frameRecording.indirectDrawGroups = this->vkState->indirectDrawGroups;
+                frameRecording.gpuObjectBuffer = cullingFrame.objectBuffer;
+            }
+        }
+        else
+        {
+            // Only models inside the camera frustum are drawn.
+            this->vkState->visibleModels.clear();
+            this->vkState->frustumCuller.setFrustum(this->vkState->camera.viewProjection);
+            this->vkState->frustumCuller.cull(models, &this->vkState->visibleModels);
+
+            if (this->vkState->visibleModels.size() > this->vkState->instanceCapacities[this->vkState->currentFrame])
+            {
+                growInstanceBuffer(this->vkState->currentFrame, static_cast<uint32_t>(this->vkState->visibleModels.size()));
+            }
+
+            buildDrawCommands(this->vkState->visibleModels, this->vkState->currentFrame, &(this->vkState->drawCommands));
+
+            // Transforms live in the instance buffer, moving models leave the recorded draws untouched.
+            isFrameDirty = isFrameDirty
+                        || frameRecording.drawCommands != this->vkState->drawCommands
+                        || frameRecording.instanceBuffer != this->vkState->instanceBuffers[this->vkState->currentFrame];
+
+            if (isFrameDirty)
+            {
+#if ENABLE_COMMAND_RECORDING_BENCHMARK
+                if (this->vkState->drawCommands.size() != this->vkState->benchmarkedDrawCount)
+                {
+                    this->vkState->benchmarkedDrawCount = this->vkState->drawCommands.size();
+                    benchmarkCommandRecording(this->vkState->currentFrame, this->vkState->drawCommands);
+                }
+#endif
+
+                resetFrameCommandPools(this->vkState->currentFrame);
+
+                frameRecording.secondaryCommandBufferCount = recordSecondaryCommandBuffers(
+                    this->vkState->currentFrame, this->vkState->drawCommands, this->vkState->recordingWorkerPool->getWorkerCount()
+                );
+                frameRecording.drawCommands = this->vkState->drawCommands;
+                frameRecording.instanceBuffer = this->vkState->instanceBuffers[this->vkState->currentFrame];
+            }
+        }
+
+        if (isFrameDirty)
+        {
+            frameRecording.vertexBuffer = this->vkState->vertexGeometryBuffer.buffer;
+            frameRecording.indexBuffer = this->vkState->indexGeometryBuffer.buffer;
+            frameRecording.isImageRecorded.assign(this->vkState->swapchainImageCount, false);
+        }
+
+        if (frameRecording.isImageRecorded[activeSwapchainImageId])
+        {
+            ++this->vkState->reusedCommandBufferCount;
+        }
+        else
+        {
+            recordCommandBuffer(commandBuffer, activeSwapchainImageId, this->vkState->currentFrame);
+            frameRecording.isImageRecorded[activeSwapchainImageId] = true;
+            ++this->vkState->recordedCommandBufferCount;
+        }
 
         VkSemaphore waitSemaphores[] = { this->vkState->imageAvailableSemaphores[this->vkState->currentFrame] };
         VkSemaphore signalSemaphores[] = { this->vkState->renderFinishedSemaphores[this->vkState->currentFrame] };
@@ -2055,13 +4153,16 @@ namespace xr
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitPipelineStages;
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &(this->vkState->commandBuffers[activeSwapchainImageId]);
+        submitInfo.pCommandBuffers = &commandBuffer;
         submitInfo.signalSemaphoreCount = static_cast<uint32_t>(sizeof(signalSemaphores) / sizeof(signalSemaphores[0]));
         submitInfo.pSignalSemaphores = signalSemaphores;
 
         result = vkQueueSubmit(this->vkState->graphicsQueue, 1, &submitInfo, this->vkState->inFlightFences[this->vkState->currentFrame]);
         CHECK_ERROR(result);
 
+        this->vkState->framePacer.onSubmit(this->vkState->currentFrame);
+        this->vkState->frameNumbers[this->vkState->currentFrame] = ++this->vkState->submittedFrameCount;
+
         VkSwapchainKHR swapchains[] = { this->vkState->swapchain };
 
         VkPresentInfoKHR presentInfo = {};
@@ -2080,13 +4181,13 @@ namespace xr
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
             logf("Swapchain out of date after presenting");
-            recreateSwapChain(models);
+            recreateSwapChain();
             return;
         }
         else if (result == VK_SUBOPTIMAL_KHR)
         {
             logf("Swapchain suboptimal after presenting");
-            recreateSwapChain(models);
+            recreateSwapChain();
             return;
         }
         else
@@ -2094,21 +4195,146 @@ namespace xr
             CHECK_ERROR(result);
         }
 
-        waitForIdle();
+#if ENABLE_FRAME_PIPELINING_BENCHMARK
+        // Serialized frames end the way render() used to, with the CPU waiting until the GPU is done with the frame.
+        if (this->vkState->framePipeliningBenchmark.isSerialized)
+        {
+            waitForIdle();
+        }
+#endif
     }
 
-    void Renderer::updateUniformBuffer(std::vector<Model *> models, uint32_t imageIndex)
+    XR_API void Renderer::setGpuDrivenRenderingEnabled(bool isEnabled)
     {
-        for (size_t index = 0; index < models.size(); ++index)
+        if (isEnabled && !this->vkState->isGpuDrivenRenderingAvailable)
+        {
+            logf("GPU driven rendering not available, drawing from the CPU");
+            return;
+        }
+
+        if (isEnabled == this->vkState->isGpuDrivenRenderingEnabled)
+        {
+            return;
+        }
+
+        this->vkState->isGpuDrivenRenderingEnabled = isEnabled;
+
+        // The pools of a frame are only reset once its fence was waited on, a default recording makes render() do that
+        // and record the new path instead of replaying the old one.
+        for (FrameRecording &frameRecording : this->vkState->frameRecordings)
+        {
+            frameRecording = FrameRecording();
+        }
+
+        logf("---------- %s driven rendering ----------", isEnabled ? "GPU" : "CPU");
+    }
+
+    XR_API CullingStatistics Renderer::getCullingStatistics()
+    {
+        // On the GPU path the counts are read back one frame in flight later, cullTime is the host side object update.
+        if (this->vkState->isGpuDrivenRenderingEnabled)
+        {
+            return this->vkState->gpuCullingStatistics;
+        }
+
+        return this->vkState->frustumCuller.getStatistics();
+    }
+
+    XR_API FramePacingStatistics Renderer::getFramePacingStatistics()
+    {
+        return this->vkState->framePacer.getStatistics(this->vkState->MAX_FRAMES_IN_FLIGHT);
+    }
+
+    XR_API void Renderer::processStreamedAssets(AssetStreamer *assetStreamer, uint32_t maxAssetsPerBatch)
+    {
+        std::vector<StreamedAsset *> &uploadingAssets = assetStreamer->uploadingAssets;
+
+        // Only one streaming batch is in flight, it is retired once its fence has signaled so this never blocks.
+        if (!uploadingAssets.empty())
+        {
+            if (!isUploadBatchComplete())
+            {
+                return;
+            }
+
+            waitForUploadBatch();
+
+            for (StreamedAsset *asset : uploadingAssets)
+            {
+                initTextureDescriptorSet(asset->model);
+                asset->status.store(AssetStatus::READY, std::memory_order_release);
+
+                logf("Streamed asset %llu ready, loaded in %.2f ms: %s", static_cast<unsigned long long>(asset->id), asset->loadTimeInMilliseconds, asset->modelFilePath.c_str());
+            }
+
+            uploadingAssets.clear();
+        }
+
+        StreamedAsset *asset = nullptr;
+
+        while (uploadingAssets.size() < maxAssetsPerBatch && assetStreamer->popLoaded(&asset))
+        {
+            // Cancelled or failed on the worker, nothing left to release.
+            if (asset->status.load(std::memory_order_acquire) != AssetStatus::LOADED)
+            {
+                logf("Streamed asset %llu dropped: %s", static_cast<unsigned long long>(asset->id), asset->modelFilePath.c_str());
+                continue;
+            }
+
+            if (asset->isCancelRequested.load(std::memory_order_acquire))
+            {
+                AssetStreamer::releaseCpuData(asset);
+                delete asset->model;
+                asset->model = nullptr;
+                asset->status.store(AssetStatus::CANCELLED, std::memory_order_release);
+                continue;
+            }
+
+            if (!this->vkState->isUploadBatchOpen)
+            {
+                beginUploadBatch();
+            }
+
+            Model *model = asset->model;
+
+            initTextureImage(model, asset->pixels, static_cast<uint32_t>(asset->textureWidth), static_cast<uint32_t>(asset->textureHeight));
+            AssetStreamer::releaseCpuData(asset);
+
+            initTextureImageView(model);
+            initTextureSampler(model);
+            initVertexBuffer(model);
+            initIndexBuffer(model);
+
+            asset->status.store(AssetStatus::UPLOADING, std::memory_order_release);
+            uploadingAssets.push_back(asset);
+        }
+
+        if (!uploadingAssets.empty())
         {
-            Model *model = models[index];
-            void *data = nullptr;
-            vkMapMemory(this->vkState->device, model->uniformBuffersMemory[imageIndex], 0, sizeof(xr::UniformBufferObject), 0, &data);
-            memcpy(data, &model->ubo, sizeof(xr::UniformBufferObject));
-            vkUnmapMemory(this->vkState->device, model->uniformBuffersMemory[imageIndex]);
+            submitUploadBatch();
         }
     }
 
+    XR_API void Renderer::updateCamera(const glm::mat4 &view, const glm::mat4 &projection)
+    {
+        this->vkState->camera.view = view;
+        this->vkState->camera.projection = projection;
+        this->vkState->camera.viewProjection = projection * view;
+        this->vkState->camera.position = glm::inverse(view)[3];
+        extractFrustumPlanes(this->vkState->camera.viewProjection, this->vkState->camera.frustumPlanes);
+    }
+
+    void Renderer::updateUniformBuffer(size_t frameIndex)
+    {
+        // Same projection scale as buildDrawCommands(), the surface size may have changed since updateCamera().
+        this->vkState->camera.lodParameters.x = std::abs(this->vkState->camera.projection[1][1]) * this->vkState->swapchainExtent.height * 0.5f;
+        this->vkState->camera.lodParameters.y = this->vkState->lodPixelErrorThreshold;
+
+        // The ring buffer stays mapped for its whole lifetime, so updating the camera is a plain copy.
+        char *frameData = static_cast<char *>(this->vkState->uniformRingBufferAllocation.mappedData) + (frameIndex * this->vkState->uniformFrameSize);
+        memcpy(frameData, &(this->vkState->camera), sizeof(xr::CameraUniformBufferObject));
+    }
+
     // Debug methods
 
     void Renderer::printGpuProperties(VkPhysicalDeviceProperties *properties, uint32_t currentGpuIndex, uint32_t totalGpuCount)
@@ -3,6 +3,14 @@
 #include "utils.h"
 #include "logger.h"
 
+#include <thread>
+
+#if defined (_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace xr {
     XR_API void checkError(const VkResult result, const char* file, const uint32_t lineNumber)
     {
@@ -132,6 +140,66 @@ namespace xr {
         return true;
     }
 
+    XR_API bool writeFileAtomically(const char* fileName, const char* data, size_t size)
+    {
+        // Unique per thread, two threads may write the same file at once.
+        std::stringstream temporaryPathStream;
+        temporaryPathStream<<fileName<<".tmp"<<std::this_thread::get_id();
+        std::string temporaryPath = temporaryPathStream.str();
+
+        FILE* file = fopen(temporaryPath.c_str(), "wb");
+
+        if(!file)
+        {
+            return false;
+        }
+
+        // The data has to reach the disk before the rename does, otherwise a crash can leave the new name
+        // pointing at an empty or partial file.
+        bool isWritten = fwrite(data, 1, size, file) == size && fflush(file) == 0;
+
+        #if defined (_WIN32)
+        isWritten = isWritten && _commit(_fileno(file)) == 0;
+        #else
+        isWritten = isWritten && fsync(fileno(file)) == 0;
+        #endif
+
+        isWritten = (fclose(file) == 0) && isWritten;
+
+        if(!isWritten)
+        {
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+
+        #if defined (_WIN32)
+        bool isRenamed = MoveFileExA(temporaryPath.c_str(), fileName, MOVEFILE_REPLACE_EXISTING) != 0;
+        #else
+        bool isRenamed = std::rename(temporaryPath.c_str(), fileName) == 0;
+        #endif
+
+        if(!isRenamed)
+        {
+            std::remove(temporaryPath.c_str());
+        }
+
+        return isRenamed;
+    }
+
+    XR_API uint64_t hashBytes(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = 14695981039346656037ull;
+
+        for(size_t counter = 0; counter < size; ++counter)
+        {
+            hash ^= bytes[counter];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
     XR_API size_t currentDateTime(char *dateTimeString, size_t size)
     {
         time_t now = time(NULL);
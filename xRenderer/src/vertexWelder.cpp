@@ -0,0 +1,227 @@
+#include "vertexWelder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace xr
+{
+    static const uint64_t EMPTY_SLOT = UINT64_MAX;
+    static const uint32_t INDEX_MASK = UINT32_MAX;
+
+    static inline uint32_t floatBits(float value)
+    {
+        // Adding 0.0f turns -0.0f into 0.0f, both compare equal so they must hash the same.
+        value += 0.0f;
+
+        uint32_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Grid cell of value, attribute / tolerance past +-2^62 (or infinite) is clamped there instead of overflowing the cast.
+    static inline uint64_t quantize(float value, double inverseTolerance)
+    {
+        const double cellLimit = 4611686018427387904.0;
+        double cell = std::floor(static_cast<double>(value) * inverseTolerance + 0.5);
+
+        if (std::isnan(cell))
+        {
+            // NaN never compares equal, its bit pattern is as good a key as any.
+            return floatBits(value);
+        }
+
+        cell = std::min(std::max(cell, -cellLimit), cellLimit);
+        return static_cast<uint64_t>(static_cast<int64_t>(cell));
+    }
+
+    static inline uint64_t hashKey(const VertexKey &key)
+    {
+        uint64_t hash = 0x9E3779B97F4A7C15ull;
+
+        for (uint64_t value : key.values)
+        {
+            hash = (hash ^ value) * 0xBF58476D1CE4E5B9ull;
+            hash ^= hash >> 31;
+        }
+
+        // Final avalanche, from MurmurHash3's fmix64.
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    VertexWelder::VertexWelder(std::vector<Vertex> *vertices, size_t expectedCount, float tolerance)
+    {
+        this->vertices = vertices;
+        this->tolerance = tolerance;
+        this->inverseTolerance = (tolerance > 0.0f) ? 1.0 / tolerance : 0.0;
+
+        // Keep the load factor at or below one half for the expected count.
+        size_t slotCount = 16;
+
+        while (slotCount < expectedCount * 2)
+        {
+            slotCount *= 2;
+        }
+
+        this->slots.assign(slotCount, EMPTY_SLOT);
+        this->slotMask = slotCount - 1;
+
+        assert(vertices->empty() && "VertexWelder expects an empty vertex array.");
+    }
+
+    VertexKey VertexWelder::makeKey(const Vertex &vertex)
+    {
+        const float attributes[8] = {
+            vertex.position.x,
+            vertex.position.y,
+            vertex.position.z,
+            vertex.color.x,
+            vertex.color.y,
+            vertex.color.z,
+            vertex.textureCoordinates.x,
+            vertex.textureCoordinates.y
+        };
+
+        VertexKey key = {};
+
+        for (uint32_t counter = 0; counter < 8; ++counter)
+        {
+            if (this->tolerance > 0.0f)
+            {
+                key.values[counter] = quantize(attributes[counter], this->inverseTolerance);
+            }
+            else
+            {
+                key.values[counter] = floatBits(attributes[counter]);
+            }
+        }
+
+        return key;
+    }
+
+    uint32_t VertexWelder::weld(const Vertex &vertex)
+    {
+        VertexKey key = this->makeKey(vertex);
+        uint64_t hash = hashKey(key);
+        uint64_t tag = hash & ~static_cast<uint64_t>(INDEX_MASK);
+
+        for (size_t slotIndex = hash & this->slotMask;; slotIndex = (slotIndex + 1) & this->slotMask)
+        {
+            ++this->probeCount;
+            uint64_t slot = this->slots[slotIndex];
+
+            if (slot == EMPTY_SLOT)
+            {
+                uint32_t vertexIndex = static_cast<uint32_t>(this->keys.size());
+                this->vertices->push_back(vertex);
+                this->keys.push_back(key);
+                this->slots[slotIndex] = tag | vertexIndex;
+
+                if (this->keys.size() * 2 > this->slots.size())
+                {
+                    this->grow();
+                }
+
+                return vertexIndex;
+            }
+
+            uint32_t vertexIndex = static_cast<uint32_t>(slot & INDEX_MASK);
+
+            if ((slot & ~static_cast<uint64_t>(INDEX_MASK)) == tag && this->keys[vertexIndex] == key)
+            {
+                return vertexIndex;
+            }
+        }
+    }
+
+    void VertexWelder::grow()
+    {
+        std::vector<uint64_t> oldSlots;
+        oldSlots.swap(this->slots);
+
+        this->slots.assign(oldSlots.size() * 2, EMPTY_SLOT);
+        this->slotMask = this->slots.size() - 1;
+
+        for (uint64_t slot : oldSlots)
+        {
+            if (slot == EMPTY_SLOT)
+            {
+                continue;
+            }
+
+            size_t slotIndex = hashKey(this->keys[slot & INDEX_MASK]) & this->slotMask;
+
+            while (this->slots[slotIndex] != EMPTY_SLOT)
+            {
+                slotIndex = (slotIndex + 1) & this->slotMask;
+            }
+
+            this->slots[slotIndex] = slot;
+        }
+    }
+
+    void benchmarkVertexWelding(const char *name, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &vertexIndices)
+    {
+        // Expanded corner stream, the input both paths see while loading a model.
+        std::vector<Vertex> corners;
+        corners.reserve(vertexIndices.size());
+
+        for (uint32_t vertexIndex : vertexIndices)
+        {
+            corners.push_back(vertices[vertexIndex]);
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        std::vector<Vertex> mapVertices;
+        std::vector<uint32_t> mapIndices;
+        std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+
+        for (const Vertex &nextVertex : corners)
+        {
+            if (uniqueVertices.count(nextVertex) == 0)
+            {
+                uniqueVertices[nextVertex] = static_cast<uint32_t>(mapVertices.size());
+                mapVertices.push_back(nextVertex);
+            }
+
+            mapIndices.push_back(uniqueVertices[nextVertex]);
+        }
+
+        auto mapEndTime = std::chrono::high_resolution_clock::now();
+
+        std::vector<Vertex> weldedVertices;
+        std::vector<uint32_t> weldedIndices;
+        weldedIndices.reserve(corners.size());
+        VertexWelder welder(&weldedVertices, corners.size());
+
+        for (const Vertex &nextVertex : corners)
+        {
+            weldedIndices.push_back(welder.weld(nextVertex));
+        }
+
+        auto weldEndTime = std::chrono::high_resolution_clock::now();
+
+        size_t collisionCount = 0;
+
+        for (size_t bucket = 0; bucket < uniqueVertices.bucket_count(); ++bucket)
+        {
+            collisionCount += (uniqueVertices.bucket_size(bucket) > 1) ? uniqueVertices.bucket_size(bucket) - 1 : 0;
+        }
+
+        float mapTime = std::chrono::duration<float, std::chrono::milliseconds::period>(mapEndTime - startTime).count();
+        float weldTime = std::chrono::duration<float, std::chrono::milliseconds::period>(weldEndTime - mapEndTime).count();
+
+        logf("---------- Vertex welding benchmark: %s ----------", name);
+        logf("Corners\t\t\t: %zu", corners.size());
+        logf("Unique vertices\t\t: %zu (map) / %zu (welder)", mapVertices.size(), weldedVertices.size());
+        logf("unordered_map\t\t: %f ms, %zu bucket collisions", mapTime, collisionCount);
+        logf("VertexWelder\t\t: %f ms, %f probes per lookup", weldTime, static_cast<float>(welder.getProbeCount()) / std::max<size_t>(corners.size(), 1));
+        logf("Identical output\t: %s", (mapVertices == weldedVertices && mapIndices == weldedIndices) ? "yes" : "NO");
+    }
+} // namespace xr
@@ -0,0 +1,104 @@
+#include "workerPool.h"
+
+#include <algorithm>
+
+namespace xr
+{
+    XR_API WorkerPool::WorkerPool(uint32_t workerCount)
+    {
+        workerCount = std::max<uint32_t>(workerCount, 1);
+
+        for (uint32_t workerIndex = 1; workerIndex < workerCount; ++workerIndex)
+        {
+            this->threads.emplace_back(&WorkerPool::threadLoop, this, workerIndex);
+        }
+    }
+
+    XR_API WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+        }
+
+        this->startCondition.notify_all();
+
+        for (std::thread &thread : this->threads)
+        {
+            thread.join();
+        }
+
+        this->threads.clear();
+    }
+
+    XR_API uint32_t WorkerPool::getWorkerCount() const
+    {
+        return static_cast<uint32_t>(this->threads.size()) + 1;
+    }
+
+    XR_API void WorkerPool::run(uint32_t workerCount, const std::function<void(uint32_t)> &job)
+    {
+        workerCount = std::min(std::max<uint32_t>(workerCount, 1), getWorkerCount());
+
+        if (workerCount > 1)
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->job = &job;
+                this->jobWorkerCount = workerCount;
+                this->runningCount = workerCount - 1;
+                ++this->generation;
+            }
+
+            this->startCondition.notify_all();
+        }
+
+        job(0);
+
+        if (workerCount > 1)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->doneCondition.wait(lock, [this]() { return this->runningCount == 0; });
+            this->job = nullptr;
+        }
+    }
+
+    void WorkerPool::threadLoop(uint32_t workerIndex)
+    {
+        uint64_t seenGeneration = 0;
+
+        while (true)
+        {
+            const std::function<void(uint32_t)> *job = nullptr;
+
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->startCondition.wait(lock, [this, seenGeneration]() { return this->isStopping || this->generation != seenGeneration; });
+
+                if (this->isStopping)
+                {
+                    return;
+                }
+
+                seenGeneration = this->generation;
+
+                // Workers beyond the job's worker count sit this job out.
+                if (workerIndex >= this->jobWorkerCount)
+                {
+                    continue;
+                }
+
+                job = this->job;
+            }
+
+            (*job)(workerIndex);
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                --this->runningCount;
+            }
+
+            this->doneCondition.notify_one();
+        }
+    }
+} // namespace xr